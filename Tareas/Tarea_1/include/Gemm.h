@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// Row-major double precision GEMM, c = a * b with a [n x k], b [k x m] and
+// c [n x m]. lda, ldb and ldc are the row strides. c is overwritten and must
+// not overlap a or b. With transposeA, a holds the [k x n] matrix whose
+// transpose is used, and likewise for transposeB; the transposes are read
+// in place while packing.
+//
+// The operands are copied in cache sized blocks into packed buffers laid out
+// for a register tiled micro-kernel chosen at runtime for the CPU (AVX-512,
+// AVX2 + FMA or portable C++). Blocks of rows of c run on separate threads.
+// The packed buffers belong to the calling thread and are reused, so only
+// the first call of a given size allocates.
+void gemm(std::size_t n, std::size_t m, std::size_t k, const double *a,
+          std::size_t lda, const double *b, std::size_t ldb, double *c,
+          std::size_t ldc, bool transposeA = false, bool transposeB = false);
+
+const char *gemmKernel();             // Name of the micro-kernel in use
+void setGemmThreads(unsigned threads); // 0 uses every hardware thread
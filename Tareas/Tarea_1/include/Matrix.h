@@ -1,59 +1,746 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Pool.h"
+
+// Extent that marks a dimension known only at runtime
+constexpr std::size_t dynamicSize = std::numeric_limits<std::size_t>::max();
+
+// Matrix<T> is sized at runtime and keeps its elements in pooled, 64 byte
+// aligned storage (see Pool.h).
+// Matrix<T, R, C> has its size in the type, keeps its elements inline and
+// unrolls its arithmetic at compile time, for the many small 3x3 and 4x4
+// operations. Both offer the same element access, arithmetic and views, but
+// only Matrix<T> and its views form expression templates, take the
+// uninitialized tag and run the blocked product; a fixed-size matrix joins
+// those through its views. T defaults to double, so a plain Matrix is the
+// dynamic double precision matrix.
+template <typename T = double, std::size_t R = dynamicSize,
+          std::size_t C = dynamicSize>
+class Matrix;
+
+template <typename T> class ConstMatrixView;
+template <typename T> class MatrixView;
+template <typename T> class TransposedMatrix;
+
+// Passed to a constructor to skip zero filling, for matrices that are about
+// to be overwritten whole
+struct UninitializedTag
+{
+};
+constexpr UninitializedTag uninitialized{};
 
-class Matrix
+// Anything that can be read element by element like a matrix: Matrix<T>,
+// views of it and the lazy expressions built by +, - and scaling (see
+// below).
+// Elements are read flat in row-major order through operator[].
+template <typename Derived> struct MatrixExpression
+{
+    const Derived &self() const
+    {
+        return static_cast<const Derived &>(*this);
+    }
+};
+
+template <typename T>
+class Matrix<T, dynamicSize, dynamicSize>
+    : public MatrixExpression<Matrix<T>>
 {
 private:
-    std::unique_ptr<double[]> mat; // Store the matrix
-    int n = 0;                     // Number of rows
-    int m = 0;                     // Number of columns
+    PoolArray<T> mat;  // Store the matrix
+    std::size_t n = 0; // Number of rows
+    std::size_t m = 0; // Number of columns
 
 public:
-    Matrix();             // Empty constructor
-    Matrix(int n);        // Constructor, vector like [1xn]
-    Matrix(int n, int m); // Constructor [nxm], n:rows, m: columns
+    typedef T value_type;
+
+    Matrix();                  // Empty constructor
+    Matrix(std::ptrdiff_t n);  // Constructor, vector like [1xn]
+    Matrix(std::ptrdiff_t n,
+           std::ptrdiff_t m);  // Constructor [nxm], n:rows, m: columns
+    Matrix(std::ptrdiff_t n, std::ptrdiff_t m,
+           UninitializedTag); // Constructor [nxm] with unspecified values
     Matrix(const Matrix &
                matrix); // Copy constructor,
                         // https://www.geeksforgeeks.org/copy-constructor-in-cpp/
-    ~Matrix();          // Destructor
+    Matrix(Matrix &&matrix) noexcept; // Move constructor, leaves matrix empty
+    template <typename E>
+    Matrix(const MatrixExpression<E> &expression); // Evaluate an expression
+    ~Matrix();                                     // Destructor
 
     // Setters and getters
-    double &operator()(std::size_t x,
-                       std::size_t y); // Set value to (i,j) <row,column>
-    const double &operator()(
-        std::size_t x,
-        std::size_t y) const; // Get value from (i,j) <row,column>
-    void fill(double value);  // Fill all the matrix with a value
+    T &operator()(std::size_t x,
+                  std::size_t y); // Set value to (i,j) <row,column>
+    const T &operator()(std::size_t x,
+                        std::size_t y) const; // Get value from (i,j)
+                                              // <row,column>
+    void fill(T value); // Fill all the matrix with a value
+    T operator[](std::size_t i) const
+    {
+        return mat[i];
+    } // Get value i in row-major order
+    T *data() { return mat.get(); } // Elements in row-major order
+    const T *data() const { return mat.get(); }
+
+    // Views, share the storage of the matrix instead of copying
+    MatrixView<T> view();                // The whole matrix
+    ConstMatrixView<T> view() const;
+    MatrixView<T> row(std::size_t x);    // Row x, [1xm]
+    ConstMatrixView<T> row(std::size_t x) const;
+    MatrixView<T> column(std::size_t y); // Column y, [nx1]
+    ConstMatrixView<T> column(std::size_t y) const;
+    MatrixView<T> block(std::size_t x, std::size_t y, std::size_t rows,
+                        std::size_t columns); // [rows x columns] from (x,y)
+    ConstMatrixView<T> block(std::size_t x, std::size_t y, std::size_t rows,
+                             std::size_t columns) const;
 
     // Dimensions
-    std::tuple<int, int> size() const; // Returns a list of the size of the
-                                       // matrix, e.g. [2,4], 2 rows, 4 columns
-    int length()
+    std::tuple<std::size_t, std::size_t>
+    size() const; // Returns a list of the size of the matrix, e.g. [2,4],
+                  // 2 rows, 4 columns
+    std::size_t length()
         const; // Return max dimension, usefull for vectors, e.g. [2,4] -> 4
 
     // Values
-    double max() const; // Maximum value of the matrix
-    double min() const; // Minimum value of the matrix
-
-    // Utilitary functions
-    friend std::ostream &operator<<(
-        std::ostream &os, const Matrix &mat); // Display matrix to console
-    friend std::istream &operator>>(
-        std::istream &is, Matrix &mat); // Interactive create matrix from
-                                        // console
+    T max() const; // Maximum value of the matrix
+    T min() const; // Minimum value of the matrix
 
     // Booleans
     bool operator==(const Matrix &matrix) const; // Equal operator
     bool operator!=(const Matrix &matrix) const; // Not equal operator
 
     // Mathematical operation
-    Matrix &operator=(const Matrix &matrix);  // Assignment operator (copy)
-    Matrix &operator*=(const Matrix &matrix); // Multiplication
-    Matrix &operator*=(double a);             // Multiply by a constant
-    Matrix &operator+=(const Matrix &matrix); // Add
-    Matrix &operator-=(const Matrix &matrix); // Substract
-    void transpose();                         // Transpose the matrix
+    Matrix &operator=(const Matrix &matrix); // Assignment operator (copy),
+                                             // reuses the storage when the
+                                             // sizes match
+    Matrix &operator=(Matrix &&matrix) noexcept; // Assignment operator (move)
+    template <typename E>
+    Matrix &operator=(const MatrixExpression<E> &expression);
+    template <typename E>
+    Matrix &operator*=(const MatrixExpression<E> &expression); // Multiplication
+    Matrix &operator*=(T a);                  // Multiply by a constant
+    template <typename E>
+    Matrix &operator+=(const MatrixExpression<E> &expression); // Add
+    template <typename E>
+    Matrix &operator-=(const MatrixExpression<E> &expression); // Substract
+    void transpose(); // Transpose the matrix in place
+    TransposedMatrix<T> transposed() const; // Transposed view, copies nothing
+
+    // Whether writing target element by element could change an element
+    // before this reads it, see the expression templates below
+    template <typename U>
+    bool conflicts(const ConstMatrixView<U> &target) const;
+
+private:
+    // Applies op(current, expression[i]) to every element, in one loop
+    template <typename E, typename Op>
+    void update(const MatrixExpression<E> &expression, Op op);
+};
+
+// Sizes alone give a double matrix, expressions keep their element type
+Matrix()->Matrix<double>;
+Matrix(std::ptrdiff_t)->Matrix<double>;
+Matrix(std::ptrdiff_t, std::ptrdiff_t)->Matrix<double>;
+Matrix(std::ptrdiff_t, std::ptrdiff_t, UninitializedTag)->Matrix<double>;
+template <typename E>
+Matrix(const MatrixExpression<E> &)->Matrix<typename E::value_type>;
+
+namespace detail
+{
+// Calls f(0), f(1), ..., f(N - 1) as N separate statements
+template <typename F, std::size_t... I>
+constexpr void unroll(F &&f, std::index_sequence<I...>)
+{
+    (f(I), ...);
+}
+
+template <std::size_t N, typename F> constexpr void unroll(F &&f)
+{
+    unroll(f, std::make_index_sequence<N>());
+}
+} // namespace detail
+
+// Fixed-size matrix. The elements live in the object itself, so creating
+// one never allocates, and every loop is expanded over the R x C elements,
+// so the compiler sees straight-line code it can keep in registers. Every
+// operation except the views is constexpr. Its own operators only combine
+// fixed-size matrices of matching sizes and build no expression templates;
+// to mix one with Matrix<T>, views or expressions, go through view(), row(),
+// column() or block(), which read and write the elements in place.
+template <typename T, std::size_t R, std::size_t C> class Matrix
+{
+    static_assert(R != dynamicSize && C != dynamicSize,
+                  "[Matrix] Either both or none of the dimensions are fixed.");
+    static_assert(R > 0 && C > 0,
+                  "[Matrix] Matrix dimensions must be positive.");
+
+private:
+    std::array<T, R * C> mat{}; // Store the matrix, zero initialized
+
+public:
+    typedef T value_type;
+
+    constexpr Matrix() = default; // Zero matrix [RxC]
+
+    // Setters and getters
+    constexpr T &operator()(std::size_t x, std::size_t y)
+    {
+        return mat[x * C + y];
+    } // Set value to (i,j) <row,column>
+    constexpr const T &operator()(std::size_t x, std::size_t y) const
+    {
+        return mat[x * C + y];
+    } // Get value from (i,j) <row,column>
+    constexpr void fill(T value)
+    {
+        detail::unroll<R * C>([&](std::size_t i) { mat[i] = value; });
+    } // Fill all the matrix with a value
+    constexpr T operator[](std::size_t i) const
+    {
+        return mat[i];
+    } // Get value i in row-major order
+    constexpr T *data() { return mat.data(); } // Elements in row-major order
+    constexpr const T *data() const { return mat.data(); }
+
+    // Views, share the storage of the matrix instead of copying
+    MatrixView<T> view() { return {data(), 0, R, C, C, 1}; } // The whole
+                                                              // matrix
+    ConstMatrixView<T> view() const { return {data(), 0, R, C, C, 1}; }
+    MatrixView<T> row(std::size_t x) { return view().row(x); } // Row x, [1xC]
+    ConstMatrixView<T> row(std::size_t x) const { return view().row(x); }
+    MatrixView<T> column(std::size_t y)
+    {
+        return view().column(y);
+    } // Column y, [Rx1]
+    ConstMatrixView<T> column(std::size_t y) const
+    {
+        return view().column(y);
+    }
+    MatrixView<T> block(std::size_t x, std::size_t y, std::size_t rows,
+                        std::size_t columns)
+    {
+        return view().block(x, y, rows, columns);
+    } // [rows x columns] from (x,y)
+    ConstMatrixView<T> block(std::size_t x, std::size_t y, std::size_t rows,
+                             std::size_t columns) const
+    {
+        return view().block(x, y, rows, columns);
+    }
+
+    // Dimensions
+    constexpr std::tuple<std::size_t, std::size_t> size() const
+    {
+        return {R, C};
+    }
+    constexpr std::size_t length() const { return std::max(R, C); }
+
+    // Values
+    constexpr T max() const
+    {
+        T value = mat[0];
+        detail::unroll<R * C>(
+            [&](std::size_t i) { value = std::max(value, mat[i]); });
+        return value;
+    } // Maximum value of the matrix
+    constexpr T min() const
+    {
+        T value = mat[0];
+        detail::unroll<R * C>(
+            [&](std::size_t i) { value = std::min(value, mat[i]); });
+        return value;
+    } // Minimum value of the matrix
+
+    // Booleans
+    constexpr bool operator==(const Matrix &matrix) const
+    {
+        bool equal = true;
+        detail::unroll<R * C>(
+            [&](std::size_t i) { equal = equal && mat[i] == matrix.mat[i]; });
+        return equal;
+    } // Equal operator
+    constexpr bool operator!=(const Matrix &matrix) const
+    {
+        return !(*this == matrix);
+    } // Not equal operator
+
+    // Mathematical operation
+    constexpr Matrix &operator+=(const Matrix &matrix)
+    {
+        detail::unroll<R * C>([&](std::size_t i) { mat[i] += matrix.mat[i]; });
+        return *this;
+    } // Add
+    constexpr Matrix &operator-=(const Matrix &matrix)
+    {
+        detail::unroll<R * C>([&](std::size_t i) { mat[i] -= matrix.mat[i]; });
+        return *this;
+    } // Substract
+    constexpr Matrix &operator*=(T a)
+    {
+        detail::unroll<R * C>([&](std::size_t i) { mat[i] *= a; });
+        return *this;
+    } // Multiply by a constant
+    constexpr Matrix &operator*=(const Matrix<T, C, C> &matrix)
+    {
+        return *this = *this * matrix;
+    } // Multiplication
+    constexpr void transpose()
+    {
+        static_assert(R == C, "[Matrix] Only square fixed-size matrices can "
+                              "be transposed in place, use transposed().");
+        detail::unroll<R * C>([&](std::size_t i) {
+            std::size_t x = i / C, y = i % C;
+            if (x < y)
+            {
+                T value = mat[i];
+                mat[i] = mat[y * C + x];
+                mat[y * C + x] = value;
+            }
+        });
+    } // Transpose the matrix in place
+    constexpr Matrix<T, C, R> transposed() const
+    {
+        Matrix<T, C, R> result;
+        detail::unroll<R * C>(
+            [&](std::size_t i) { result(i % C, i / C) = mat[i]; });
+        return result;
+    } // Transposed copy, as cheap as a view at these sizes
+
+    friend constexpr Matrix operator+(Matrix a, const Matrix &b)
+    {
+        return a += b;
+    }
+    friend constexpr Matrix operator-(Matrix a, const Matrix &b)
+    {
+        return a -= b;
+    }
+    friend constexpr Matrix operator*(Matrix a, T s) { return a *= s; }
+    friend constexpr Matrix operator*(T s, Matrix a) { return a *= s; }
+
+    // c = a * b into an existing c, every product spelled out
+    template <std::size_t K>
+    friend constexpr void multiply(const Matrix &a, const Matrix<T, C, K> &b,
+                                   Matrix<T, R, K> &c)
+    {
+        if (static_cast<const void *>(&c) == &a ||
+            static_cast<const void *>(&c) == &b)
+            throw std::logic_error(
+                "[Matrix] Output matrix must differ from the operands.");
+
+        detail::unroll<R * K>([&](std::size_t i) {
+            T sum{};
+            detail::unroll<C>(
+                [&](std::size_t p) { sum += a(i / K, p) * b(p, i % K); });
+            c(i / K, i % K) = sum;
+        });
+    }
+    template <std::size_t K>
+    friend constexpr Matrix<T, R, K> operator*(const Matrix &a,
+                                               const Matrix<T, C, K> &b)
+    {
+        Matrix<T, R, K> c;
+        multiply(a, b, c);
+        return c;
+    }
+};
+
+// Non-owning window on elements laid out with any strides: element (x, y)
+// is data[x * rowStride + y * columnStride]. Rows, columns and blocks of a
+// matrix, and its transpose, are views of its storage, so none of them
+// copies anything. Views read like matrices in every expression and
+// product, and must not outlive the storage they look at.
+template <typename T>
+class ConstMatrixView : public MatrixExpression<ConstMatrixView<T>>
+{
+protected:
+    const T *mat = nullptr;      // First element
+    std::size_t n = 0;           // Number of rows
+    std::size_t m = 0;           // Number of columns
+    std::size_t rowStep = 0;     // Elements between consecutive rows
+    std::size_t columnStep = 1;  // Elements between consecutive columns
+
+public:
+    typedef T value_type;
+
+    ConstMatrixView() = default; // Empty view
+    ConstMatrixView(const T *data, std::size_t offset, std::size_t rows,
+                    std::size_t columns, std::size_t rowStride,
+                    std::size_t columnStride)
+        : mat(data + offset), n(rows), m(columns), rowStep(rowStride),
+          columnStep(columnStride)
+    {
+    }
+    ConstMatrixView(const Matrix<T> &matrix) // The whole matrix
+        : ConstMatrixView(matrix.data(), 0, std::get<0>(matrix.size()),
+                          std::get<1>(matrix.size()),
+                          std::get<1>(matrix.size()), 1)
+    {
+    }
+
+    const T &operator()(std::size_t x, std::size_t y) const
+    {
+        return mat[x * rowStep + y * columnStep];
+    } // Get value from (i,j) <row,column>
+    T operator[](std::size_t i) const
+    {
+        return (*this)(i / m, i % m);
+    } // Get value i in row-major order
+    const T *data() const { return mat; } // Element (0,0)
+    std::size_t rowStride() const { return rowStep; }
+    std::size_t columnStride() const { return columnStep; }
+
+    // Dimensions
+    std::tuple<std::size_t, std::size_t> size() const { return {n, m}; }
+    std::size_t length() const { return std::max(n, m); }
+
+    // Views of the view
+    ConstMatrixView row(std::size_t x) const { return block(x, 0, 1, m); }
+    ConstMatrixView column(std::size_t y) const { return block(0, y, n, 1); }
+    ConstMatrixView block(std::size_t x, std::size_t y, std::size_t rows,
+                          std::size_t columns) const;
+    ConstMatrixView transposed() const
+    {
+        return {mat, 0, m, n, columnStep, rowStep};
+    }
+
+    // Whether any element of the two views shares memory
+    template <typename U> bool overlaps(const ConstMatrixView<U> &view) const;
+    // Whether writing target element by element could change an element
+    // of this view before it is read: they overlap in a different layout
+    template <typename U>
+    bool conflicts(const ConstMatrixView<U> &target) const;
+};
+
+// Writable view. Assigning to a view writes its elements and never rebinds
+// it, so A.row(0) = A.row(1) copies a row; the target may overlap what the
+// expression reads, which is then evaluated into a temporary first.
+template <typename T> class MatrixView : public ConstMatrixView<T>
+{
+public:
+    MatrixView() = default; // Empty view
+    MatrixView(T *data, std::size_t offset, std::size_t rows,
+               std::size_t columns, std::size_t rowStride,
+               std::size_t columnStride)
+        : ConstMatrixView<T>(data, offset, rows, columns, rowStride,
+                             columnStride)
+    {
+    }
+    MatrixView(Matrix<T> &matrix) : ConstMatrixView<T>(matrix) {}
+    MatrixView(const MatrixView &view) = default;
+
+    T &operator()(std::size_t x, std::size_t y) const
+    {
+        // Only ever built from writable storage
+        return const_cast<T &>(ConstMatrixView<T>::operator()(x, y));
+    } // Set value to (i,j) <row,column>
+    T *data() const { return const_cast<T *>(this->mat); }
+    void fill(T value); // Fill all the view with a value
+
+    // Views of the view
+    MatrixView row(std::size_t x) const { return block(x, 0, 1, this->m); }
+    MatrixView column(std::size_t y) const
+    {
+        return block(0, y, this->n, 1);
+    }
+    MatrixView block(std::size_t x, std::size_t y, std::size_t rows,
+                     std::size_t columns) const;
+    MatrixView transposed() const
+    {
+        return {data(), 0, this->m, this->n, this->columnStep, this->rowStep};
+    }
+
+    // Mathematical operation, on the viewed elements
+    MatrixView &operator=(const MatrixView &view);
+    template <typename E>
+    MatrixView &operator=(const MatrixExpression<E> &expression);
+    template <typename E>
+    MatrixView &operator+=(const MatrixExpression<E> &expression); // Add
+    template <typename E>
+    MatrixView &operator-=(const MatrixExpression<E> &expression); // Substract
+    MatrixView &operator*=(T a); // Multiply by a constant
+
+private:
+    // Applies op(current, expression[i]) to every element, in one loop
+    template <typename E, typename Op>
+    void update(const MatrixExpression<E> &expression, Op op);
+};
+
+// Read-only transpose of a matrix that shares its storage. Products read it
+// straight from the original layout, so A.transposed() * B never builds A^T.
+template <typename T> class TransposedMatrix : public ConstMatrixView<T>
+{
+private:
+    const Matrix<T> &matrix;
+
+public:
+    explicit TransposedMatrix(const Matrix<T> &matrix)
+        : ConstMatrixView<T>(ConstMatrixView<T>(matrix).transposed()),
+          matrix(matrix)
+    {
+    }
+
+    const Matrix<T> &source() const { return matrix; } // The matrix viewed
+};
+
+// Utilitary functions
+template <typename T, std::size_t R, std::size_t C>
+std::ostream &operator<<(std::ostream &os,
+                         const Matrix<T, R, C> &matrix); // Display matrix to
+                                                         // console
+template <typename T>
+std::istream &operator>>(std::istream &is,
+                         Matrix<T> &matrix); // Interactive create matrix from
+                                             // console
+
+// Matrix product of any two of matrices, views and expressions. Operands
+// with a unit stride in either direction are read in place, others and
+// expressions are evaluated first.
+template <typename L, typename R>
+Matrix<typename L::value_type> operator*(const MatrixExpression<L> &a,
+                                         const MatrixExpression<R> &b);
+
+// c = a * b into an existing c of the right size, without allocating
+template <typename L, typename R>
+void multiply(const MatrixExpression<L> &a, const MatrixExpression<R> &b,
+              Matrix<typename L::value_type> &c);
+template <typename L, typename R>
+void multiply(const MatrixExpression<L> &a, const MatrixExpression<R> &b,
+              MatrixView<typename L::value_type> c);
+
+// Expression templates. +, - and scaling build a tree of these instead of
+// computing anything; assigning the tree to a Matrix evaluates every
+// element in a single pass, so A += B * 2.0 - C allocates nothing. Named
+// matrices are held by reference and temporaries by value, so an
+// expression is safe to use within the statement that builds it.
+namespace detail
+{
+template <typename D> std::true_type isExpression(const MatrixExpression<D> *);
+std::false_type isExpression(...);
+} // namespace detail
+
+template <typename T>
+constexpr bool isMatrixExpression =
+    decltype(detail::isExpression(std::declval<std::decay_t<T> *>()))::value;
+
+template <typename T> constexpr bool isDynamicMatrix = false;
+template <typename T> constexpr bool isDynamicMatrix<Matrix<T>> = true;
+
+template <typename T>
+using MatrixOperand =
+    std::conditional_t<std::is_lvalue_reference_v<T> &&
+                           isDynamicMatrix<std::decay_t<T>>,
+                       const std::decay_t<T> &, std::decay_t<T>>;
+
+template <typename L, typename R, typename Op>
+class MatrixBinary : public MatrixExpression<MatrixBinary<L, R, Op>>
+{
+private:
+    L l;
+    R r;
+
+public:
+    typedef typename std::decay_t<L>::value_type value_type;
+
+    template <typename A, typename B>
+    MatrixBinary(A &&a, B &&b) : l(std::forward<A>(a)), r(std::forward<B>(b))
+    {
+        if (l.size() != r.size())
+            throw std::logic_error("[Matrix] Matrix dimensions must match.");
+    }
+
+    std::tuple<std::size_t, std::size_t> size() const { return l.size(); }
+    value_type operator[](std::size_t i) const { return Op()(l[i], r[i]); }
+    template <typename U>
+    bool conflicts(const ConstMatrixView<U> &target) const
+    {
+        return l.conflicts(target) || r.conflicts(target);
+    }
+};
+
+template <typename E>
+class MatrixScaled : public MatrixExpression<MatrixScaled<E>>
+{
+public:
+    typedef typename std::decay_t<E>::value_type value_type;
+
+private:
+    E e;
+    value_type a;
+
+public:
+    template <typename A>
+    MatrixScaled(A &&e, value_type a) : e(std::forward<A>(e)), a(a)
+    {
+    }
+
+    std::tuple<std::size_t, std::size_t> size() const { return e.size(); }
+    value_type operator[](std::size_t i) const { return e[i] * a; }
+    template <typename U>
+    bool conflicts(const ConstMatrixView<U> &target) const
+    {
+        return e.conflicts(target);
+    }
 };
+
+template <typename L, typename R,
+          typename = std::enable_if_t<isMatrixExpression<L> &&
+                                      isMatrixExpression<R>>>
+MatrixBinary<MatrixOperand<L>, MatrixOperand<R>, std::plus<>>
+operator+(L &&l, R &&r)
+{
+    return {std::forward<L>(l), std::forward<R>(r)};
+}
+
+template <typename L, typename R,
+          typename = std::enable_if_t<isMatrixExpression<L> &&
+                                      isMatrixExpression<R>>>
+MatrixBinary<MatrixOperand<L>, MatrixOperand<R>, std::minus<>>
+operator-(L &&l, R &&r)
+{
+    return {std::forward<L>(l), std::forward<R>(r)};
+}
+
+template <typename E, typename = std::enable_if_t<isMatrixExpression<E>>>
+MatrixScaled<MatrixOperand<E>>
+operator*(E &&e, typename std::decay_t<E>::value_type a)
+{
+    return {std::forward<E>(e), a};
+}
+
+template <typename E, typename = std::enable_if_t<isMatrixExpression<E>>>
+MatrixScaled<MatrixOperand<E>>
+operator*(typename std::decay_t<E>::value_type a, E &&e)
+{
+    return {std::forward<E>(e), a};
+}
+
+template <typename T>
+template <typename E>
+Matrix<T>::Matrix(const MatrixExpression<E> &expression)
+{
+    *this = expression;
+}
+
+template <typename T>
+template <typename E>
+Matrix<T> &Matrix<T>::operator=(const MatrixExpression<E> &expression)
+{
+    const E &e = expression.self();
+    if (size() == e.size() && !e.conflicts(view()))
+    {
+        // Element i only reads element i, so A = B - A is safe in place
+        update(expression, [](T, T value) { return value; });
+        return *this;
+    }
+
+    auto [rows, columns] = e.size();
+    std::size_t count = rows * columns;
+    PoolArray<T> result(count, false);
+    for (std::size_t i = 0; i < count; i++)
+        result[i] = e[i];
+    mat = std::move(result);
+    n = rows;
+    m = columns;
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+Matrix<T> &Matrix<T>::operator+=(const MatrixExpression<E> &expression)
+{
+    update(expression, std::plus<>());
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+Matrix<T> &Matrix<T>::operator-=(const MatrixExpression<E> &expression)
+{
+    update(expression, std::minus<>());
+    return *this;
+}
+
+template <typename T>
+template <typename E, typename Op>
+void Matrix<T>::update(const MatrixExpression<E> &expression, Op op)
+{
+    const E &e = expression.self();
+    if (size() != e.size())
+        throw std::logic_error("[Matrix] Matrix dimensions must match.");
+    if (e.conflicts(view()))
+    {
+        // Reads overlap the elements written in another order
+        update(Matrix<T>(expression), op);
+        return;
+    }
+
+    T *values = mat.get();
+    std::size_t count = n * m;
+    for (std::size_t i = 0; i < count; i++)
+        values[i] = op(values[i], e[i]);
+}
+
+template <typename T>
+template <typename E>
+MatrixView<T> &MatrixView<T>::operator=(const MatrixExpression<E> &expression)
+{
+    update(expression, [](T, T value) { return value; });
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+MatrixView<T> &MatrixView<T>::operator+=(const MatrixExpression<E> &expression)
+{
+    update(expression, std::plus<>());
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+MatrixView<T> &MatrixView<T>::operator-=(const MatrixExpression<E> &expression)
+{
+    update(expression, std::minus<>());
+    return *this;
+}
+
+template <typename T>
+template <typename E, typename Op>
+void MatrixView<T>::update(const MatrixExpression<E> &expression, Op op)
+{
+    const E &e = expression.self();
+    if (this->size() != e.size())
+        throw std::logic_error("[Matrix] Matrix dimensions must match.");
+    if (e.conflicts(*this))
+    {
+        // Reads overlap the elements written in another order
+        update(Matrix<T>(expression), op);
+        return;
+    }
+
+    for (std::size_t x = 0, i = 0; x < this->n; x++)
+    {
+        T *values = data() + x * this->rowStep;
+        for (std::size_t y = 0; y < this->m; y++, i++)
+            values[y * this->columnStep] =
+                op(values[y * this->columnStep], e[i]);
+    }
+}
+
+#include "Matrix.tpp"
+
+// Compiled once in Matrix.cpp
+extern template class Matrix<double>;
+extern template class Matrix<float>;
+extern template class Matrix<int>;
@@ -0,0 +1,582 @@
+// Definitions of the dynamic Matrix<T>, included at the end of Matrix.h
+#include "Gemm.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace detail
+{
+// Square blocks smaller than this are transposed element by element
+inline constexpr std::size_t transposeBlock = 32;
+
+// Swaps rows [r0, r1) x columns [c0, c1) with their mirror across the
+// diagonal, splitting the longer side until the pair fits in cache.
+template <typename T>
+void swapMirrored(T *mat, std::size_t ld, std::size_t r0, std::size_t r1,
+                  std::size_t c0, std::size_t c1)
+{
+    if (r1 - r0 <= transposeBlock && c1 - c0 <= transposeBlock)
+    {
+        for (std::size_t i = r0; i < r1; i++)
+            for (std::size_t j = c0; j < c1; j++)
+                std::swap(mat[i * ld + j], mat[j * ld + i]);
+    }
+    else if (r1 - r0 >= c1 - c0)
+    {
+        std::size_t half = r0 + (r1 - r0) / 2;
+        swapMirrored(mat, ld, r0, half, c0, c1);
+        swapMirrored(mat, ld, half, r1, c0, c1);
+    }
+    else
+    {
+        std::size_t half = c0 + (c1 - c0) / 2;
+        swapMirrored(mat, ld, r0, r1, c0, half);
+        swapMirrored(mat, ld, r0, r1, half, c1);
+    }
+}
+
+// Cache-oblivious in-place transpose of the diagonal block [begin, end)
+template <typename T>
+void transposeSquare(T *mat, std::size_t ld, std::size_t begin,
+                     std::size_t end)
+{
+    if (end - begin <= transposeBlock)
+    {
+        for (std::size_t i = begin; i < end; i++)
+            for (std::size_t j = i + 1; j < end; j++)
+                std::swap(mat[i * ld + j], mat[j * ld + i]);
+        return;
+    }
+    std::size_t half = begin + (end - begin) / 2;
+    transposeSquare(mat, ld, begin, half);
+    transposeSquare(mat, ld, half, end);
+    swapMirrored(mat, ld, half, end, begin, half);
+}
+
+// In-place transpose of an n x m matrix by following the permutation's
+// cycles. Element i moves to i * n mod (n * m - 1); one bit per element
+// marks what is already in place.
+template <typename T> void transposeCycles(T *mat, std::size_t n, std::size_t m)
+{
+    std::size_t last = n * m - 1;
+    std::vector<bool> moved(n * m);
+    for (std::size_t start = 1; start < last; start++)
+    {
+        if (moved[start])
+            continue;
+
+        T value = mat[start];
+        std::size_t i = start;
+        do
+        {
+            i = i * n % last;
+            std::swap(value, mat[i]);
+            moved[i] = true;
+        } while (i != start);
+    }
+}
+
+// Same contract as gemm(). Doubles take the blocked SIMD kernels; other
+// element types run a plain i-k-j loop, which streams rows of b and c.
+template <typename T>
+void multiplyRaw(std::size_t n, std::size_t m, std::size_t k, const T *a,
+                 std::size_t lda, const T *b, std::size_t ldb, T *c,
+                 std::size_t ldc, bool transposeA, bool transposeB)
+{
+    if constexpr (std::is_same_v<T, double>)
+    {
+        gemm(n, m, k, a, lda, b, ldb, c, ldc, transposeA, transposeB);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            T *row = c + i * ldc;
+            std::fill(row, row + m, T());
+            for (std::size_t p = 0; p < k; p++)
+            {
+                T value = transposeA ? a[p * lda + i] : a[i * lda + p];
+                for (std::size_t j = 0; j < m; j++)
+                    row[j] += value * (transposeB ? b[j * ldb + p]
+                                                  : b[p * ldb + j]);
+            }
+        }
+    }
+}
+
+// Shared by every product. gemm reads an operand in place when one of its
+// strides is 1, as a row-major matrix or as the transpose of one; other
+// operands, and outputs without unit column stride, go through a
+// contiguous copy.
+template <typename T>
+void product(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<T> c)
+{
+    auto [n, k] = a.size();
+    auto [bRows, m] = b.size();
+    if (k != bRows || c.size() != std::make_tuple(n, m))
+        throw std::logic_error(
+            "[Matrix] Incompatible matrix dimensions for multiplication.");
+    if (c.overlaps(a) || c.overlaps(b))
+        throw std::logic_error(
+            "[Matrix] Output matrix must differ from the operands.");
+
+    if (c.columnStride() != 1)
+    {
+        Matrix<T> result(n, m, uninitialized);
+        product(a, b, result.view());
+        c = result;
+        return;
+    }
+    Matrix<T> aCopy, bCopy;
+    if (a.rowStride() != 1 && a.columnStride() != 1)
+    {
+        aCopy = a;
+        a = aCopy;
+    }
+    if (b.rowStride() != 1 && b.columnStride() != 1)
+    {
+        bCopy = b;
+        b = bCopy;
+    }
+    bool transposeA = a.columnStride() != 1;
+    bool transposeB = b.columnStride() != 1;
+    multiplyRaw(n, m, k, a.data(),
+                transposeA ? a.columnStride() : a.rowStride(), b.data(),
+                transposeB ? b.columnStride() : b.rowStride(), c.data(),
+                c.rowStride(), transposeA, transposeB);
+}
+
+template <typename T, typename A, typename B>
+Matrix<T> productOf(const A &a, const B &b)
+{
+    if (std::get<1>(a.size()) != std::get<0>(b.size()))
+        throw std::logic_error(
+            "[Matrix] Incompatible matrix dimensions for multiplication.");
+
+    Matrix<T> result(std::get<0>(a.size()), std::get<1>(b.size()),
+                     uninitialized);
+    product<T>(a, b, result);
+    return result;
+}
+
+// Operands of a product as matrices or views, evaluating expressions
+template <typename T> const Matrix<T> &evaluate(const Matrix<T> &matrix)
+{
+    return matrix;
+}
+
+template <typename T>
+const ConstMatrixView<T> &evaluate(const ConstMatrixView<T> &view)
+{
+    return view;
+}
+
+template <typename E>
+Matrix<typename E::value_type> evaluate(const MatrixExpression<E> &expression)
+{
+    return expression;
+}
+} // namespace detail
+
+// Constructors
+template <typename T> Matrix<T>::Matrix() {}
+
+template <typename T> Matrix<T>::Matrix(std::ptrdiff_t n)
+{
+    if (n <= 0)
+        throw std::logic_error("[Matrix] Vector length must be positive.");
+
+    this->n = 1;
+    this->m = n;
+    mat = PoolArray<T>(n);
+}
+
+template <typename T> Matrix<T>::Matrix(std::ptrdiff_t n, std::ptrdiff_t m)
+{
+    if (n <= 0 || m <= 0)
+        throw std::logic_error("[Matrix] Matrix dimensions must be positive.");
+
+    this->n = n;
+    this->m = m;
+    mat = PoolArray<T>(this->n * this->m);
+}
+
+template <typename T>
+Matrix<T>::Matrix(std::ptrdiff_t n, std::ptrdiff_t m, UninitializedTag)
+{
+    if (n <= 0 || m <= 0)
+        throw std::logic_error("[Matrix] Matrix dimensions must be positive.");
+
+    this->n = n;
+    this->m = m;
+    mat = PoolArray<T>(this->n * this->m, false);
+}
+
+template <typename T>
+Matrix<T>::Matrix(const Matrix &matrix)
+    : mat(matrix.n * matrix.m, false), n(matrix.n), m(matrix.m)
+{
+    std::copy(matrix.mat.get(), matrix.mat.get() + n * m, mat.get());
+}
+
+template <typename T>
+Matrix<T>::Matrix(Matrix &&matrix) noexcept
+    : mat(std::move(matrix.mat)), n(matrix.n), m(matrix.m)
+{
+    matrix.n = 0;
+    matrix.m = 0;
+}
+
+template <typename T> Matrix<T>::~Matrix() {}
+
+// Setters & getters
+template <typename T> T &Matrix<T>::operator()(std::size_t x, std::size_t y)
+{
+    return mat[x * m + y];
+}
+
+template <typename T>
+const T &Matrix<T>::operator()(std::size_t x, std::size_t y) const
+{
+    return mat[x * m + y];
+}
+
+template <typename T> void Matrix<T>::fill(T value)
+{
+    for (std::size_t i = 0; i < n * m; i++)
+        mat[i] = value;
+}
+
+// Views
+template <typename T> MatrixView<T> Matrix<T>::view()
+{
+    return MatrixView<T>(*this);
+}
+
+template <typename T> ConstMatrixView<T> Matrix<T>::view() const
+{
+    return ConstMatrixView<T>(*this);
+}
+
+template <typename T> MatrixView<T> Matrix<T>::row(std::size_t x)
+{
+    return view().row(x);
+}
+
+template <typename T> ConstMatrixView<T> Matrix<T>::row(std::size_t x) const
+{
+    return view().row(x);
+}
+
+template <typename T> MatrixView<T> Matrix<T>::column(std::size_t y)
+{
+    return view().column(y);
+}
+
+template <typename T>
+ConstMatrixView<T> Matrix<T>::column(std::size_t y) const
+{
+    return view().column(y);
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::block(std::size_t x, std::size_t y, std::size_t rows,
+                               std::size_t columns)
+{
+    return view().block(x, y, rows, columns);
+}
+
+template <typename T>
+ConstMatrixView<T> Matrix<T>::block(std::size_t x, std::size_t y,
+                                    std::size_t rows,
+                                    std::size_t columns) const
+{
+    return view().block(x, y, rows, columns);
+}
+
+// Dimensions
+template <typename T>
+std::tuple<std::size_t, std::size_t> Matrix<T>::size() const
+{
+    return {n, m};
+}
+
+template <typename T> std::size_t Matrix<T>::length() const
+{
+    return std::max(n, m);
+}
+
+// Values
+template <typename T> T Matrix<T>::max() const
+{
+    if (n == 0 || m == 0)
+        throw std::logic_error("[Matrix] Matrix must have values.");
+
+    T max_value = mat[0];
+    for (std::size_t i = 0; i < n * m; i++)
+        max_value = std::max(max_value, mat[i]);
+    return max_value;
+}
+
+template <typename T> T Matrix<T>::min() const
+{
+    if (n == 0 || m == 0)
+        throw std::logic_error("[Matrix] Matrix must have values.");
+
+    T min_value = mat[0];
+    for (std::size_t i = 0; i < n * m; i++)
+        min_value = std::min(min_value, mat[i]);
+    return min_value;
+}
+
+// Utilitary functions
+template <typename T, std::size_t R, std::size_t C>
+std::ostream &operator<<(std::ostream &os, const Matrix<T, R, C> &matrix)
+{
+    auto [n, m] = matrix.size();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < m; j++)
+            os << matrix(i, j) << ' ';
+        os << '\n';
+    }
+    return os;
+}
+
+template <typename T>
+std::istream &operator>>(std::istream &is, Matrix<T> &matrix)
+{
+    std::ptrdiff_t n = 0, m = 0;
+    std::cout << "Ingrese el tamaño de la matriz: ";
+    is >> n >> m;
+    if (n <= 0 || m <= 0)
+        throw std::logic_error("[Matrix] Matrix dimensions must be positive.");
+    matrix = Matrix<T>(n, m);
+    std::cout << "Ingrese los valores de la matriz: ";
+    for (std::size_t i = 0; i < std::size_t(n * m); i++)
+        is >> matrix.data()[i];
+    return is;
+}
+
+// Booleans
+template <typename T> bool Matrix<T>::operator==(const Matrix &matrix) const
+{
+    if (this->size() != matrix.size())
+        return false;
+
+    for (std::size_t i = 0; i < n * m; i++)
+    {
+        if (mat[i] != matrix.mat[i])
+            return false;
+    }
+    return true;
+}
+
+template <typename T> bool Matrix<T>::operator!=(const Matrix &matrix) const
+{
+    return !(*this == matrix);
+}
+
+// Mathematical operation
+template <typename T> Matrix<T> &Matrix<T>::operator=(const Matrix &matrix)
+{
+    if (this == &matrix)
+        return *this;
+
+    if (n * m != matrix.n * matrix.m)
+        mat = PoolArray<T>(matrix.n * matrix.m, false);
+    n = matrix.n;
+    m = matrix.m;
+    std::copy(matrix.mat.get(), matrix.mat.get() + n * m, mat.get());
+    return *this;
+}
+
+template <typename T>
+Matrix<T> &Matrix<T>::operator=(Matrix &&matrix) noexcept
+{
+    if (this == &matrix)
+        return *this;
+
+    mat = std::move(matrix.mat);
+    n = matrix.n;
+    m = matrix.m;
+    matrix.n = 0;
+    matrix.m = 0;
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+Matrix<T> &Matrix<T>::operator*=(const MatrixExpression<E> &expression)
+{
+    const auto &matrix = detail::evaluate(expression.self());
+    auto [rows, columns] = matrix.size();
+    if (m != rows)
+        throw std::logic_error(
+            "[Matrix] Incompatible matrix dimensions for multiplication.");
+
+    // The product takes over the result's storage instead of copying it
+    Matrix result(n, columns, uninitialized);
+    multiply(*this, matrix, result);
+    mat = std::move(result.mat);
+    m = columns;
+    return *this;
+}
+
+template <typename T> Matrix<T> &Matrix<T>::operator*=(T a)
+{
+    for (std::size_t i = 0; i < n * m; i++)
+        mat[i] *= a;
+    return *this;
+}
+
+template <typename T> void Matrix<T>::transpose()
+{
+    if (n == m)
+        detail::transposeSquare(mat.get(), m, 0, n);
+    else if (n > 1 && m > 1)
+        detail::transposeCycles(mat.get(), n, m);
+    std::swap(n, m);
+}
+
+template <typename T> TransposedMatrix<T> Matrix<T>::transposed() const
+{
+    return TransposedMatrix<T>(*this);
+}
+
+template <typename T>
+template <typename U>
+bool Matrix<T>::conflicts(const ConstMatrixView<U> &target) const
+{
+    return view().conflicts(target);
+}
+
+template <typename L, typename R>
+Matrix<typename L::value_type> operator*(const MatrixExpression<L> &a,
+                                         const MatrixExpression<R> &b)
+{
+    const auto &left = detail::evaluate(a.self());
+    const auto &right = detail::evaluate(b.self());
+    return detail::productOf<typename L::value_type>(left, right);
+}
+
+template <typename L, typename R>
+void multiply(const MatrixExpression<L> &a, const MatrixExpression<R> &b,
+              Matrix<typename L::value_type> &c)
+{
+    multiply(a, b, c.view());
+}
+
+template <typename L, typename R>
+void multiply(const MatrixExpression<L> &a, const MatrixExpression<R> &b,
+              MatrixView<typename L::value_type> c)
+{
+    const auto &left = detail::evaluate(a.self());
+    const auto &right = detail::evaluate(b.self());
+    detail::product<typename L::value_type>(left, right, c);
+}
+
+// Views
+template <typename T>
+ConstMatrixView<T> ConstMatrixView<T>::block(std::size_t x, std::size_t y,
+                                             std::size_t rows,
+                                             std::size_t columns) const
+{
+    if (x + rows > n || y + columns > m)
+        throw std::logic_error("[Matrix] View out of bounds.");
+
+    return {mat, x * rowStep + y * columnStep, rows, columns, rowStep,
+            columnStep};
+}
+
+template <typename T>
+template <typename U>
+bool ConstMatrixView<T>::overlaps(const ConstMatrixView<U> &view) const
+{
+    auto [rows, columns] = view.size();
+    if (n == 0 || m == 0 || rows == 0 || columns == 0)
+        return false;
+
+    // Byte ranges from the first to past the last element
+    auto begin = reinterpret_cast<std::uintptr_t>(mat);
+    auto end = reinterpret_cast<std::uintptr_t>(&(*this)(n - 1, m - 1) + 1);
+    auto viewBegin = reinterpret_cast<std::uintptr_t>(view.data());
+    auto viewEnd =
+        reinterpret_cast<std::uintptr_t>(&view(rows - 1, columns - 1) + 1);
+    if (begin >= viewEnd || viewBegin >= end)
+        return false;
+
+    // Views of one row-major matrix, or of its transpose, cover rectangles
+    // of its lines of `stride` elements, so they share an element only if
+    // the rectangles intersect. Other layouts keep the byte range test.
+    std::size_t stride = std::max(rowStep, columnStep);
+    std::uintptr_t origin = std::min(begin, viewBegin);
+    auto rectangle = [&](std::uintptr_t start, std::size_t rowStride,
+                         std::size_t columnStride, std::size_t rows,
+                         std::size_t columns)
+    {
+        // First line, first column, lines and width, or no width
+        std::size_t offset = (start - origin) / sizeof(T);
+        if (columnStride != 1 || rowStride != stride)
+            std::swap(rows, columns);
+        if (std::min(rowStride, columnStride) != 1 ||
+            std::max(rowStride, columnStride) != stride ||
+            offset % stride + columns > stride)
+            columns = 0;
+        return std::make_tuple(offset / stride, offset % stride, rows,
+                               columns);
+    };
+    auto [line, column, lines, width] =
+        rectangle(begin, rowStep, columnStep, n, m);
+    auto [viewLine, viewColumn, viewLines, viewWidth] =
+        rectangle(viewBegin, view.rowStride(), view.columnStride(), rows,
+                  columns);
+    if (sizeof(T) != sizeof(U) || (viewBegin - origin) % sizeof(T) ||
+        (begin - origin) % sizeof(T) || width == 0 || viewWidth == 0)
+        return true;
+    return line < viewLine + viewLines && viewLine < line + lines &&
+           column < viewColumn + viewWidth && viewColumn < column + width;
+}
+
+template <typename T>
+template <typename U>
+bool ConstMatrixView<T>::conflicts(const ConstMatrixView<U> &target) const
+{
+    bool sameLayout = static_cast<const void *>(mat) == target.data() &&
+                      sizeof(T) == sizeof(U) && size() == target.size() &&
+                      rowStep == target.rowStride() &&
+                      columnStep == target.columnStride();
+    return !sameLayout && overlaps(target);
+}
+
+template <typename T>
+MatrixView<T> MatrixView<T>::block(std::size_t x, std::size_t y,
+                                   std::size_t rows, std::size_t columns) const
+{
+    ConstMatrixView<T> view = ConstMatrixView<T>::block(x, y, rows, columns);
+    return {data(), std::size_t(view.data() - this->mat), rows, columns,
+            this->rowStep, this->columnStep};
+}
+
+template <typename T> void MatrixView<T>::fill(T value)
+{
+    for (std::size_t x = 0; x < this->n; x++)
+        for (std::size_t y = 0; y < this->m; y++)
+            (*this)(x, y) = value;
+}
+
+template <typename T>
+MatrixView<T> &MatrixView<T>::operator=(const MatrixView &view)
+{
+    update(view, [](T, T value) { return value; });
+    return *this;
+}
+
+template <typename T> MatrixView<T> &MatrixView<T>::operator*=(T a)
+{
+    for (std::size_t x = 0; x < this->n; x++)
+        for (std::size_t y = 0; y < this->m; y++)
+            (*this)(x, y) *= a;
+    return *this;
+}
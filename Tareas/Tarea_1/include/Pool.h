@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// 64 byte aligned blocks for matrix storage. Sizes are rounded up to a power
+// of two and freed blocks are kept per size class in a cache that belongs to
+// the freeing thread, so a loop that creates and drops matrices of the same
+// sizes stops reaching the system allocator after its first iteration. The
+// cache is bounded; blocks beyond it, and blocks too large for any class,
+// go straight back to the system.
+void *poolAllocate(std::size_t bytes);
+void poolFree(void *block, std::size_t bytes) noexcept; // Same bytes as
+                                                         // allocated
+void poolTrim(); // Frees every block cached by the calling thread
+
+// Elements of a Matrix<T>, count T in one pooled block. Zero filled unless
+// created with initialize = false, in which case they hold garbage until
+// written.
+template <typename T> class PoolArray
+{
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "[Matrix] Pooled elements must be trivially destructible.");
+
+private:
+    T *values = nullptr;
+    std::size_t count = 0;
+
+public:
+    PoolArray() = default;
+    explicit PoolArray(std::size_t count, bool initialize = true)
+        : values(static_cast<T *>(poolAllocate(count * sizeof(T)))),
+          count(count)
+    {
+        if (initialize)
+            std::uninitialized_value_construct_n(values, count);
+        else
+            std::uninitialized_default_construct_n(values, count);
+    }
+    PoolArray(PoolArray &&array) noexcept
+        : values(std::exchange(array.values, nullptr)),
+          count(std::exchange(array.count, 0))
+    {
+    }
+    PoolArray &operator=(PoolArray &&array) noexcept
+    {
+        if (this != &array)
+        {
+            poolFree(values, count * sizeof(T));
+            values = std::exchange(array.values, nullptr);
+            count = std::exchange(array.count, 0);
+        }
+        return *this;
+    }
+    ~PoolArray() { poolFree(values, count * sizeof(T)); }
+
+    T &operator[](std::size_t i) const { return values[i]; }
+    T *get() const { return values; }
+};
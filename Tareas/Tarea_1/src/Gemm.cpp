@@ -0,0 +1,326 @@
+#include "../include/Gemm.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Blocking, sized for doubles: a KC x NC panel of b lives in L3, an MC x KC
+// block of a in L2 and the KC x NR sliver of b the micro-kernel sweeps in L1.
+// MC is a multiple of every MR and NC of every NR.
+const size_t KC = 256;
+const size_t MC = 96;
+const size_t NC = 4096;
+const size_t maxMR = 6;
+const size_t maxNR = 16;
+
+// Below this many multiply-adds threads cost more than they save
+const double parallelWork = 1 << 21;
+
+// Computes one MR x NR tile of c from a packed sliver of a (MR values per
+// step of k) and of b (NR values per step), adding to c when accumulate is
+// set and overwriting it otherwise.
+typedef void (*MicroKernel)(size_t kc, const double *a, const double *b,
+                            double *c, size_t ldc, bool accumulate);
+
+struct Kernel {
+  const char *name;
+  size_t mr, nr;
+  MicroKernel run;
+};
+
+template <size_t MR, size_t NR>
+void microKernelGeneric(size_t kc, const double *a, const double *b,
+                        double *c, size_t ldc, bool accumulate) {
+  double tile[MR][NR] = {};
+  for (size_t p = 0; p < kc; p++, a += MR, b += NR)
+    for (size_t i = 0; i < MR; i++)
+      for (size_t j = 0; j < NR; j++)
+        tile[i][j] += a[i] * b[j];
+
+  for (size_t i = 0; i < MR; i++)
+    for (size_t j = 0; j < NR; j++)
+      c[i * ldc + j] = accumulate ? c[i * ldc + j] + tile[i][j] : tile[i][j];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 6 x 8 tile in twelve ymm accumulators, one broadcast of a per row
+__attribute__((target("avx2,fma"))) void
+microKernelAvx2(size_t kc, const double *a, const double *b, double *c,
+                size_t ldc, bool accumulate) {
+  __m256d tile[6][2];
+#pragma GCC unroll 6
+  for (size_t i = 0; i < 6; i++)
+    tile[i][0] = tile[i][1] = _mm256_setzero_pd();
+
+  for (size_t p = 0; p < kc; p++, a += 6, b += 8) {
+    __m256d b0 = _mm256_load_pd(b);
+    __m256d b1 = _mm256_load_pd(b + 4);
+#pragma GCC unroll 6
+    for (size_t i = 0; i < 6; i++) {
+      __m256d ai = _mm256_broadcast_sd(a + i);
+      tile[i][0] = _mm256_fmadd_pd(ai, b0, tile[i][0]);
+      tile[i][1] = _mm256_fmadd_pd(ai, b1, tile[i][1]);
+    }
+  }
+
+#pragma GCC unroll 6
+  for (size_t i = 0; i < 6; i++) {
+    double *row = c + i * ldc;
+    if (accumulate) {
+      tile[i][0] = _mm256_add_pd(tile[i][0], _mm256_loadu_pd(row));
+      tile[i][1] = _mm256_add_pd(tile[i][1], _mm256_loadu_pd(row + 4));
+    }
+    _mm256_storeu_pd(row, tile[i][0]);
+    _mm256_storeu_pd(row + 4, tile[i][1]);
+  }
+}
+
+// Same shape with zmm registers, 6 x 16
+__attribute__((target("avx512f"))) void
+microKernelAvx512(size_t kc, const double *a, const double *b, double *c,
+                  size_t ldc, bool accumulate) {
+  __m512d tile[6][2];
+#pragma GCC unroll 6
+  for (size_t i = 0; i < 6; i++)
+    tile[i][0] = tile[i][1] = _mm512_setzero_pd();
+
+  for (size_t p = 0; p < kc; p++, a += 6, b += 16) {
+    __m512d b0 = _mm512_load_pd(b);
+    __m512d b1 = _mm512_load_pd(b + 8);
+#pragma GCC unroll 6
+    for (size_t i = 0; i < 6; i++) {
+      __m512d ai = _mm512_set1_pd(a[i]);
+      tile[i][0] = _mm512_fmadd_pd(ai, b0, tile[i][0]);
+      tile[i][1] = _mm512_fmadd_pd(ai, b1, tile[i][1]);
+    }
+  }
+
+#pragma GCC unroll 6
+  for (size_t i = 0; i < 6; i++) {
+    double *row = c + i * ldc;
+    if (accumulate) {
+      tile[i][0] = _mm512_add_pd(tile[i][0], _mm512_loadu_pd(row));
+      tile[i][1] = _mm512_add_pd(tile[i][1], _mm512_loadu_pd(row + 8));
+    }
+    _mm512_storeu_pd(row, tile[i][0]);
+    _mm512_storeu_pd(row + 8, tile[i][1]);
+  }
+}
+#endif
+
+Kernel selectKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return {"AVX-512", 6, 16, microKernelAvx512};
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return {"AVX2", 6, 8, microKernelAvx2};
+#endif
+  return {"Generic", 4, 4, microKernelGeneric<4, 4>};
+}
+
+const Kernel &kernel() {
+  static const Kernel selected = selectKernel();
+  return selected;
+}
+
+atomic<unsigned> gemmThreads{0};
+
+// 64 byte aligned scratch that only grows
+class PackBuffer {
+public:
+  ~PackBuffer() { free(data); }
+
+  double *reserve(size_t count) {
+    if (count > capacity) {
+      free(data);
+      data = static_cast<double *>(
+          aligned_alloc(64, (count * sizeof(double) + 63) / 64 * 64));
+      if (!data) {
+        capacity = 0;
+        throw bad_alloc();
+      }
+      capacity = count;
+    }
+    return data;
+  }
+
+private:
+  double *data = nullptr;
+  size_t capacity = 0;
+};
+
+thread_local PackBuffer packedA; // One MC x KC block per thread
+thread_local PackBuffer packedB; // The current KC x NC panel
+
+// MR rows at a time, column by column, zero padded to a whole panel. A
+// transposed a is stored column by column, so its rows are contiguous.
+void packA(size_t mc, size_t kc, const double *a, size_t lda, bool transposed,
+           size_t mr, double *out) {
+  for (size_t i = 0; i < mc; i += mr, out += mr * kc) {
+    size_t rows = min(mr, mc - i);
+    for (size_t p = 0; p < kc; p++)
+      for (size_t r = 0; r < mr; r++)
+        out[p * mr + r] = r >= rows   ? 0
+                          : transposed ? a[p * lda + i + r]
+                                       : a[(i + r) * lda + p];
+  }
+}
+
+// NR columns at a time, row by row, zero padded to a whole panel
+void packB(size_t kc, size_t cols, const double *b, size_t ldb,
+           bool transposed, size_t nr, double *out) {
+  if (transposed) {
+    for (size_t j = 0; j < nr; j++)
+      for (size_t p = 0; p < kc; p++)
+        out[p * nr + j] = j < cols ? b[j * ldb + p] : 0;
+    return;
+  }
+  for (size_t p = 0; p < kc; p++, b += ldb, out += nr) {
+    for (size_t j = 0; j < cols; j++)
+      out[j] = b[j];
+    for (size_t j = cols; j < nr; j++)
+      out[j] = 0;
+  }
+}
+
+// Partial tiles on the right and bottom edges go through a full tile
+void runTile(const Kernel &kern, size_t kc, const double *a, const double *b,
+             double *c, size_t ldc, size_t rows, size_t cols,
+             bool accumulate) {
+  if (rows == kern.mr && cols == kern.nr) {
+    kern.run(kc, a, b, c, ldc, accumulate);
+    return;
+  }
+  alignas(64) double tile[maxMR * maxNR];
+  kern.run(kc, a, b, tile, kern.nr, false);
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      c[i * ldc + j] = tile[i * kern.nr + j] + (accumulate ? c[i * ldc + j] : 0);
+}
+
+// Blocks until every thread of the team has called wait(), std::barrier is
+// C++20
+class Barrier {
+public:
+  explicit Barrier(unsigned count) : count(count) {}
+
+  void wait() {
+    unique_lock<mutex> lock(guard);
+    unsigned phase = generation;
+    if (++arrived == count) {
+      arrived = 0;
+      generation++;
+      released.notify_all();
+      return;
+    }
+    released.wait(lock, [&] { return generation != phase; });
+  }
+
+private:
+  mutex guard;
+  condition_variable released;
+  unsigned count;
+  unsigned arrived = 0;
+  unsigned generation = 0;
+};
+
+// Runs work(t) for t in [0, threads), the calling thread being thread 0
+template <typename Work> void runTeam(unsigned threads, const Work &work) {
+  vector<thread> workers;
+  for (unsigned t = 1; t < threads; t++)
+    workers.emplace_back([&work, t] { work(t); });
+  work(0);
+  for (thread &worker : workers)
+    worker.join();
+}
+
+// First of the share of [0, count) that thread t of threads takes
+size_t share(size_t count, unsigned t, unsigned threads) {
+  return t * count / threads;
+}
+
+} // namespace
+
+void gemm(size_t n, size_t m, size_t k, const double *a, size_t lda,
+          const double *b, size_t ldb, double *c, size_t ldc,
+          bool transposeA, bool transposeB) {
+  if (n == 0 || m == 0)
+    return;
+  if (k == 0) {
+    for (size_t i = 0; i < n; i++)
+      fill(c + i * ldc, c + i * ldc + m, 0.0);
+    return;
+  }
+
+  const Kernel &kern = kernel();
+  unsigned threads = gemmThreads.load();
+  if (threads == 0)
+    threads = max(1u, thread::hardware_concurrency());
+  if (double(n) * m * k < parallelWork)
+    threads = 1;
+
+  size_t blocks = (n + MC - 1) / MC;
+  threads = static_cast<unsigned>(min<size_t>(threads, blocks));
+
+  size_t panelWidth = (min(NC, m) + kern.nr - 1) / kern.nr * kern.nr;
+  double *bPacked = packedB.reserve(KC * panelWidth);
+  double *aPacked = packedA.reserve(size_t(threads) * MC * KC);
+
+  // One team for the whole product: every thread walks the same panels of b,
+  // packs its share of each and multiplies its share of the blocks of a
+  Barrier barrier(threads);
+  runTeam(threads, [&](unsigned t) {
+    double *aBlock = aPacked + size_t(t) * MC * KC;
+    for (size_t jc = 0; jc < m; jc += NC) {
+      size_t nc = min(NC, m - jc);
+      size_t panels = (nc + kern.nr - 1) / kern.nr;
+
+      for (size_t pc = 0; pc < k; pc += KC) {
+        size_t kc = min(KC, k - pc);
+        bool accumulate = pc > 0;
+
+        for (size_t j = share(panels, t, threads);
+             j < share(panels, t + 1, threads); j++) {
+          size_t column = jc + j * kern.nr;
+          packB(kc, min(kern.nr, nc - j * kern.nr),
+                transposeB ? b + column * ldb + pc : b + pc * ldb + column,
+                ldb, transposeB, kern.nr, bPacked + j * kern.nr * kc);
+        }
+        barrier.wait(); // The whole panel is packed
+
+        for (size_t block = share(blocks, t, threads);
+             block < share(blocks, t + 1, threads); block++) {
+          size_t ic = block * MC;
+          size_t mc = min(MC, n - ic);
+          packA(mc, kc, transposeA ? a + pc * lda + ic : a + ic * lda + pc,
+                lda, transposeA, kern.mr, aBlock);
+
+          for (size_t jr = 0; jr < nc; jr += kern.nr)
+            for (size_t ir = 0; ir < mc; ir += kern.mr)
+              runTile(kern, kc, aBlock + ir * kc, bPacked + jr * kc,
+                      c + (ic + ir) * ldc + jc + jr, ldc,
+                      min(kern.mr, mc - ir), min(kern.nr, nc - jr),
+                      accumulate);
+        }
+        barrier.wait(); // Nobody reads the panel any more
+      }
+    }
+  });
+}
+
+const char *gemmKernel() { return kernel().name; }
+
+void setGemmThreads(unsigned threads) { gemmThreads.store(threads); }
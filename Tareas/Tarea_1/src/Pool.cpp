@@ -0,0 +1,93 @@
+#include "../include/Pool.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace {
+
+const size_t alignment = 64;
+const size_t smallestClass = 6; // 64 bytes
+const size_t classCount = 21;   // Up to 64 MiB
+const size_t blocksPerClass = 8;
+const size_t cacheBytes = size_t(64) << 20; // Cached per thread
+
+// Trivially destructible, so it stays usable while the thread's other
+// thread_local objects are destroyed; blocks freed after close go straight
+// to the system.
+struct Cache {
+  void *blocks[classCount][blocksPerClass];
+  size_t count[classCount];
+  size_t bytes;
+  bool closed;
+};
+
+thread_local Cache cache;
+
+void trim() {
+  for (size_t c = 0; c < classCount; c++)
+    while (cache.count[c] > 0)
+      free(cache.blocks[c][--cache.count[c]]);
+  cache.bytes = 0;
+}
+
+// Gives the cached blocks back when the thread ends
+struct Closer {
+  ~Closer() {
+    trim();
+    cache.closed = true;
+  }
+};
+
+thread_local Closer closer;
+
+// Size class of a block of the given bytes, classCount when none fits
+size_t sizeClass(size_t bytes) {
+  size_t c = 0;
+  while (c < classCount && (alignment << c) < bytes)
+    c++;
+  return c;
+}
+
+void *allocateAligned(size_t bytes) {
+  void *block = aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+  if (!block)
+    throw bad_alloc();
+  return block;
+}
+
+} // namespace
+
+void *poolAllocate(size_t bytes) {
+  if (bytes == 0)
+    return nullptr;
+
+  size_t c = sizeClass(bytes);
+  if (c == classCount)
+    return allocateAligned(bytes);
+  if (!cache.closed) {
+    (void)&closer; // Registers the cleanup on the thread's first use
+    if (cache.count[c] > 0) {
+      cache.bytes -= alignment << c;
+      return cache.blocks[c][--cache.count[c]];
+    }
+  }
+  return allocateAligned(alignment << c);
+}
+
+void poolFree(void *block, size_t bytes) noexcept {
+  if (!block)
+    return;
+
+  size_t c = sizeClass(bytes);
+  if (c < classCount && !cache.closed && cache.count[c] < blocksPerClass &&
+      cache.bytes + (alignment << c) <= cacheBytes) {
+    (void)&closer;
+    cache.blocks[c][cache.count[c]++] = block;
+    cache.bytes += alignment << c;
+    return;
+  }
+  free(block);
+}
+
+void poolTrim() { trim(); }
@@ -116,6 +116,362 @@ TEST(Matrix, Mathematical_operations) {
   EXPECT_EQ(d(1, 1), 154);
 }
 
+TEST(Matrix, Multiply) {
+  // Sizes that leave partial tiles and span several cache blocks
+  for (auto [n, k, m] : {make_tuple(1, 1, 1), make_tuple(7, 5, 3),
+                         make_tuple(97, 300, 45), make_tuple(130, 260, 517)}) {
+    Matrix a(n, k), b(k, m), c(n, m);
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < k; j++)
+        a(i, j) = (i * 7 + j * 3) % 11 - 5;
+    for (int i = 0; i < k; i++)
+      for (int j = 0; j < m; j++)
+        b(i, j) = (i * 5 + j * 2) % 13 - 6;
+
+    c.fill(42); // Overwritten, not added to
+    multiply(a, b, c);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        double expected = 0;
+        for (int p = 0; p < k; p++)
+          expected += a(i, p) * b(p, j);
+        ASSERT_EQ(c(i, j), expected) << n << 'x' << k << 'x' << m;
+      }
+    }
+
+    a *= b;
+    EXPECT_EQ(a, c);
+  }
+
+  // Exceptions
+  Matrix a(2, 3), b(3, 4), c(2, 4), wrong(2, 3), square(3, 3);
+  EXPECT_THROW(multiply(a, b, wrong), logic_error);
+  EXPECT_THROW(multiply(b, a, c), logic_error);
+  EXPECT_THROW(multiply(square, square, square), logic_error);
+}
+
+TEST(Matrix, Move_semantics) {
+  Matrix a(2, 3);
+  a.fill(4);
+  Matrix copy(a);
+
+  // Move constructor
+  Matrix b(move(a));
+  EXPECT_EQ(b, copy);
+  EXPECT_EQ(a.size(), make_tuple(0, 0));
+
+  // Move assignment
+  Matrix c(5, 5);
+  c = move(b);
+  EXPECT_EQ(c, copy);
+  EXPECT_EQ(b.size(), make_tuple(0, 0));
+
+  // Copy assignment into a matrix of another size
+  Matrix d(1, 1);
+  d = c;
+  EXPECT_EQ(d, copy);
+}
+
+TEST(Matrix, Expressions) {
+  Matrix a(2, 2), b(2, 2), c(2, 2);
+  a(0, 0) = 1; a(0, 1) = 2;
+  a(1, 0) = 3; a(1, 1) = 4;
+  b.fill(10);
+  c.fill(1);
+
+  // Evaluated on assignment
+  Matrix d = a + b;
+  EXPECT_EQ(d(0, 0), 11);
+  EXPECT_EQ(d(1, 1), 14);
+
+  Matrix e = a * 2.0 - c;
+  EXPECT_EQ(e(0, 1), 3);
+  EXPECT_EQ(e(1, 0), 5);
+
+  // Fused compound assignment
+  Matrix f = a;
+  f += b * 2.0 - c;
+  EXPECT_EQ(f(0, 0), 20);
+  EXPECT_EQ(f(1, 1), 23);
+
+  // The target may appear in the expression
+  f = 0.5 * (f - a) + f;
+  EXPECT_EQ(f(0, 0), 29.5);
+
+  // Matrix products are evaluated first and mix with the rest
+  Matrix g = a * b + c;
+  EXPECT_EQ(g(0, 0), 31);
+  EXPECT_EQ(g(1, 0), 71);
+  Matrix h = (a + c) * b;
+  EXPECT_EQ(h(0, 1), 50);
+
+  // Dimensions are checked when the expression is built
+  Matrix wrong(3, 2);
+  EXPECT_THROW(a + wrong, logic_error);
+  EXPECT_THROW(a -= wrong * 2.0, logic_error);
+}
+
+TEST(Matrix, Transpose) {
+  // Square sizes below and above the recursion cutoff, then rectangles
+  for (auto [n, m] : {make_tuple(1, 1), make_tuple(2, 2), make_tuple(77, 77),
+                      make_tuple(3, 5), make_tuple(1, 4), make_tuple(64, 33)}) {
+    Matrix a(n, m);
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < m; j++)
+        a(i, j) = i * 1000 + j;
+
+    Matrix t = a;
+    t.transpose();
+    ASSERT_EQ(t.size(), make_tuple(m, n));
+    for (int i = 0; i < n; i++)
+      for (int j = 0; j < m; j++)
+        ASSERT_EQ(t(j, i), a(i, j)) << n << 'x' << m;
+
+    t.transpose();
+    EXPECT_EQ(t, a);
+  }
+}
+
+TEST(Matrix, Transposed_view) {
+  Matrix a(5, 3), b(5, 4);
+  for (int i = 0; i < 5; i++) {
+    for (int j = 0; j < 3; j++)
+      a(i, j) = i - 2 * j;
+    for (int j = 0; j < 4; j++)
+      b(i, j) = i * j + 1;
+  }
+  Matrix at = a, bt = b;
+  at.transpose();
+  bt.transpose();
+
+  TransposedMatrix view = a.transposed();
+  EXPECT_EQ(view.size(), make_tuple(3, 5));
+  EXPECT_EQ(view(2, 4), a(4, 2));
+
+  // Products read the view without copying a
+  EXPECT_EQ(a.transposed() * b, at * b);
+  EXPECT_EQ(b.transposed() * a, bt * a);
+  EXPECT_EQ(a * a.transposed(), a * at);
+  EXPECT_EQ(b.transposed() * at.transposed(), bt * a);
+
+  Matrix c(4, 3);
+  multiply(b.transposed(), at.transposed(), c);
+  EXPECT_EQ(c, bt * a);
+
+  Matrix wrong(3, 3);
+  EXPECT_THROW(multiply(a.transposed(), b, wrong), logic_error);
+  EXPECT_THROW(a.transposed() * a.transposed(), logic_error);
+}
+
+TEST(Matrix, Element_types) {
+  // Counting matrices stay exact, products of other types skip the double kernels
+  Matrix<int> a(2, 3), b(3, 2);
+  for (int i = 0; i < 2; i++)
+    for (int j = 0; j < 3; j++) {
+      a(i, j) = i * 3 + j + 1;
+      b(j, i) = j * 2 + i + 7;
+    }
+  Matrix<int> c = a * b;
+  EXPECT_EQ(c.size(), make_tuple(2, 2));
+  EXPECT_EQ(c(0, 0), 58);
+  EXPECT_EQ(c(1, 1), 154);
+  Matrix<int> ba = b * a;
+  ba.transpose();
+  EXPECT_EQ(a.transposed() * b.transposed(), ba);
+
+  Matrix<int> counts(2, 2);
+  counts += c * 2 - c;
+  EXPECT_EQ(counts, c);
+  EXPECT_EQ(counts.max(), 154);
+
+  // Single precision keeps the same operations
+  Matrix<float> f(3, 3);
+  f.fill(0.5f);
+  Matrix g = f * 2.0f + f;
+  EXPECT_EQ(g(2, 2), 1.5f);
+  g.transpose();
+  g *= f;
+  EXPECT_EQ(g(0, 1), 2.25f);
+}
+
+TEST(Matrix, Fixed_size) {
+  // Everything can run at compile time
+  constexpr Matrix<int, 2, 3> a = [] {
+    Matrix<int, 2, 3> a;
+    for (size_t i = 0; i < 2; i++)
+      for (size_t j = 0; j < 3; j++)
+        a(i, j) = i * 3 + j + 1;
+    return a;
+  }();
+  constexpr Matrix<int, 3, 2> b = a.transposed();
+  constexpr Matrix<int, 2, 2> c = a * b;
+  static_assert(c(0, 0) == 14 && c(0, 1) == 32 && c(1, 1) == 77);
+  static_assert((a + a - a) * 2 == 2 * a);
+  static_assert(a.max() == 6 && b.min() == 1 && a.length() == 3);
+  static_assert(sizeof(Matrix<float, 4, 4>) == 16 * sizeof(float));
+
+  // Same results as the dynamic matrices
+  Matrix<double, 4, 4> d;
+  Matrix<double> e(4, 4);
+  for (size_t i = 0; i < 4; i++)
+    for (size_t j = 0; j < 4; j++)
+      d(i, j) = e(i, j) = double(i) - 2.0 * j;
+  Matrix<double, 4, 4> product = d;
+  product *= d;
+  e *= Matrix(e);
+  for (size_t i = 0; i < 16; i++)
+    ASSERT_EQ(product[i], e[i]);
+
+  product.transpose();
+  e.transpose();
+  EXPECT_EQ(product(1, 3), e(1, 3));
+  EXPECT_EQ(product.size(), make_tuple(4, 4));
+
+  Matrix<double, 4, 4> out;
+  EXPECT_THROW(multiply(out, d, out), logic_error);
+
+  // Views let fixed-size matrices mix with dynamic ones and expressions
+  EXPECT_EQ(d.row(1)(0, 3), d(1, 3));
+  EXPECT_EQ(d.column(2)(3, 0), d(3, 2));
+  d.block(2, 2, 2, 2).fill(0);
+  EXPECT_EQ(d(3, 3), 0);
+  Matrix<double> f = d.view() * Matrix<double>(d.view()) + e;
+  multiply(d.view(), d.view(), out.view());
+  for (size_t i = 0; i < 16; i++)
+    ASSERT_EQ(f[i], out[i] + e[i]);
+}
+
+TEST(Matrix, Views) {
+  Matrix a(4, 5);
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 5; j++)
+      a(i, j) = i * 10 + j;
+
+  // Rows, columns and blocks share the storage
+  MatrixView row = a.row(2);
+  EXPECT_EQ(row.size(), make_tuple(1, 5));
+  EXPECT_EQ(row(0, 3), 23);
+  EXPECT_EQ(a.column(4)(3, 0), 34);
+  ConstMatrixView<double> block = a.block(1, 2, 2, 3);
+  EXPECT_EQ(block(1, 2), 24);
+  EXPECT_EQ(block.transposed()(2, 1), 24);
+
+  row(0, 0) = -1;
+  EXPECT_EQ(a(2, 0), -1);
+  a.block(0, 0, 2, 2).fill(7);
+  EXPECT_EQ(a(1, 1), 7);
+  EXPECT_EQ(a(2, 2), 22);
+
+  // Views take part in every operation and write through
+  a.row(3) += a.row(0) * 2.0 - a.row(1);
+  EXPECT_EQ(a(3, 0), 37);
+  EXPECT_EQ(a(3, 4), 28);
+  a.column(1) *= 2;
+  EXPECT_EQ(a(2, 1), 42);
+  Matrix copy = a.block(1, 1, 3, 3);
+  EXPECT_EQ(copy.size(), make_tuple(3, 3));
+  EXPECT_EQ(copy(2, 2), a(3, 3));
+
+  // Any strides, here every other row and column
+  ConstMatrixView<double> sparse(a.data(), 0, 2, 3, 10, 2);
+  EXPECT_EQ(sparse(1, 2), a(2, 4));
+  Matrix dense = sparse;
+  EXPECT_EQ(dense(1, 1), a(2, 2));
+
+  // Targets that overlap what they read in another layout stay correct
+  Matrix s(3, 3), expected(3, 3);
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++) {
+      s(i, j) = i * 3 + j;
+      expected(j, i) = i * 3 + j;
+    }
+  Matrix t = s;
+  t = t.transposed();
+  EXPECT_EQ(t, expected);
+  t.view() = t.view().transposed();
+  EXPECT_EQ(t, s);
+  t.block(0, 0, 2, 2) += t.block(1, 1, 2, 2);
+  EXPECT_EQ(t(0, 0), 4);
+  EXPECT_EQ(t(1, 1), 12);
+  EXPECT_EQ(t(2, 2), 8);
+
+  EXPECT_THROW(a.block(3, 0, 2, 1), logic_error);
+  EXPECT_THROW(a.row(4), logic_error);
+  EXPECT_THROW(a.row(0) = a.column(0), logic_error);
+}
+
+TEST(Matrix, View_products) {
+  Matrix a(6, 7), b(7, 5);
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < 7; j++)
+      a(i, j) = (i * 3 + j) % 5 - 2;
+  for (int i = 0; i < 7; i++)
+    for (int j = 0; j < 5; j++)
+      b(i, j) = (i + j * 2) % 7 - 3;
+
+  // Blocks are read in place, strided views through a copy, the result
+  // compared with products of copies
+  auto check = [](const auto &left, const auto &right) {
+    Matrix l = left, r = right;
+    EXPECT_EQ(left * right, l * r);
+  };
+  check(a.block(1, 2, 3, 4), b.block(0, 1, 4, 3));
+  check(a.block(1, 2, 3, 4).transposed(), a.block(0, 0, 3, 2));
+  check(a.row(5), b);
+  check(a, b.column(3));
+  check(ConstMatrixView<double>(a.data(), 1, 3, 3, 14, 2), b.block(2, 0, 3, 5));
+  check(a.block(0, 0, 2, 2) + a.block(2, 2, 2, 2), a.block(4, 0, 2, 2));
+
+  // Into a block of a larger matrix, or a transposed one
+  Matrix c(8, 8), expected = a * b;
+  multiply(a, b, c.block(1, 2, 6, 5));
+  EXPECT_EQ(Matrix(c.block(1, 2, 6, 5)), expected);
+  EXPECT_EQ(c(0, 0), 0);
+  Matrix ct(5, 6);
+  multiply(a, b, ct.view().transposed());
+  ct.transpose();
+  EXPECT_EQ(ct, expected);
+
+  // Blocks that interleave in memory without sharing an element
+  Matrix left = a.block(0, 0, 4, 2), right = b.block(0, 0, 2, 2);
+  multiply(a.block(0, 0, 4, 2), b.block(0, 0, 2, 2), a.block(0, 3, 4, 2));
+  EXPECT_EQ(Matrix(a.block(0, 3, 4, 2)), left * right);
+  multiply(a.block(0, 0, 2, 4), a.block(2, 4, 4, 2), a.block(4, 0, 2, 2).transposed());
+  EXPECT_EQ(a(4, 1), (Matrix(a.block(0, 0, 2, 4)) * Matrix(a.block(2, 4, 4, 2)))(1, 0));
+  EXPECT_THROW(multiply(a.block(0, 0, 4, 2), right, a.block(2, 1, 4, 2)), logic_error);
+
+  Matrix square(3, 3);
+  a *= b.block(0, 0, 7, 3);
+  EXPECT_EQ(a.size(), make_tuple(6, 3));
+  EXPECT_THROW(multiply(square, square.block(0, 0, 3, 1), square.column(2)), logic_error);
+}
+
+TEST(Matrix, Storage) {
+  // Uninitialized matrices only need writing
+  Matrix u(3, 4, uninitialized);
+  EXPECT_EQ(u.size(), make_tuple(3, 4));
+  u.fill(1);
+  EXPECT_EQ(u.min(), 1);
+  EXPECT_THROW(Matrix(0, 4, uninitialized), logic_error);
+
+  // Aligned blocks, reused by the next matrix of the same size
+  const double *freed;
+  {
+    Matrix a(50, 50);
+    freed = a.data();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a.data()) % 64, 0);
+  }
+  Matrix b(50, 50, uninitialized);
+  EXPECT_EQ(b.data(), freed);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(Matrix<float>(3).data()) % 64, 0);
+
+  // Zero filled by default, even in reused storage
+  b.fill(5);
+  b = Matrix();
+  Matrix c(50, 50);
+  EXPECT_EQ(c.max(), 0);
+}
+
 TEST(Matrix, Exceptions) {
   // Constructors
   EXPECT_THROW(Matrix(-1), logic_error);
@@ -3,10 +3,10 @@ import numpy as np
 import pandas as pd
 
 csv_path = "cuda_benchmark.csv"
-df = pd.read_csv(csv_path)
+df = pd.read_csv(csv_path, comment="#")
 df["Cells/s (Millions)"] = df["Cells/s"] / 1_000_000_000
 df["Length"] = df["Length"].apply(np.log2)
-modes = ["CUDA", "CUDA Ifs", "CUDA 2D"]
+modes = ["CUDA", "CUDA Ifs", "CUDA 2D", "CUDA 2D Rows"]
 
 for mode in modes:
     mode_df = df[df["Mode"] == mode]
@@ -3,7 +3,7 @@ import numpy as np
 import pandas as pd
 
 csv_path = "opencl_benchmark.csv"
-df = pd.read_csv(csv_path)
+df = pd.read_csv(csv_path, comment="#")
 df["Cells/s (Millions)"] = df["Cells/s"] / 1_000_000_000
 df["Length"] = df["Length"].apply(np.log2)
 modes = ["OpenCL", "OpenCL Ifs", "OpenCL 2D"]
@@ -1,12 +1,19 @@
 import matplotlib.pyplot as plt
 import pandas as pd
 
-df = pd.read_csv("serial_benchmark.csv")
+df = pd.read_csv("serial_benchmark.csv", comment="#")
 df["Cells/s (Millions)"] = df["Cells/s"] / 1_000_000
 
-modes = ["Serial", "Serial Ifs", "Serial 2D"]
-colors = ["blue", "green", "red"]
-linestyles = ["-", "--", "-."]
+modes = [
+    "Serial",
+    "Serial Ifs",
+    "Serial 2D",
+    "Serial 2D Rows",
+    "Serial Bitpacked",
+    "Serial SIMD",
+]
+colors = ["blue", "green", "red", "brown", "purple", "orange"]
+linestyles = ["-", "--", "-.", "-.", ":", "-"]
 plt.figure(figsize=(10, 6))
 
 for mode, color, style in zip(modes, colors, linestyles):
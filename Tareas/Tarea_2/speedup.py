@@ -9,9 +9,10 @@ threads_cuda = {
 threads_opencl = {"OpenCL": 128, "OpenCL Ifs": 128, "OpenCL 2D": 128}
 threads_gpu = threads_cuda | threads_opencl
 
-serial_df = pd.read_csv("serial_benchmark.csv")
-cuda_df = pd.read_csv("cuda_benchmark.csv")
-opencl_df = pd.read_csv("opencl_benchmark.csv")
+serial_df = pd.read_csv("serial_benchmark.csv", comment="#")
+serial_df = serial_df[serial_df["Mode"] == "Serial"]
+cuda_df = pd.read_csv("cuda_benchmark.csv", comment="#")
+opencl_df = pd.read_csv("opencl_benchmark.csv", comment="#")
 
 serial_df["Time[μs]"] = serial_df["Time[s]"] * 1_000_000
 lengths = serial_df["Length"].unique()
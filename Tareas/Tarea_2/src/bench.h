@@ -0,0 +1,536 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "perf.h"
+#include "random.h"
+
+// Benchmark driver shared by the serial, OpenCL and CUDA binaries. Every
+// binary keeps its own engines and only takes the options, timing loop and
+// report from here.
+struct BenchOptions {
+  std::vector<std::string> engines;             // Empty runs every engine
+  std::vector<std::pair<size_t, size_t>> sizes; // Width, height
+  size_t iterations = 16;                       // Generations per repetition
+  unsigned repetitions = 5;
+  unsigned warmup = 1;
+  std::string output; // Defaults to <binary>_benchmark.csv
+  std::string format; // "csv" or "json", guessed from output when empty
+  bool counters = false; // Hardware counters around every timed block
+  // Random worlds, the seed advances with every world drawn
+  RandomOptions world = {static_cast<unsigned>(std::time(nullptr))};
+};
+
+const char *const benchUsage =
+    "  [--engine NAME,...] [--sizes WxH,...] [--iterations N]\n"
+    "  [--repetitions N] [--warmup N] [--output FILE] [--format csv|json]\n"
+    "  [--counters] [--seed N] [--density D] [--rng lcg|philox]\n"
+    "  Sizes take plain numbers or powers, 2^15x2^1-10 expands to ten sizes.\n";
+
+inline std::vector<std::string> splitList(const std::string &text) {
+  std::vector<std::string> items;
+  size_t begin = 0;
+  while (begin <= text.size()) {
+    size_t end = std::min(text.find(',', begin), text.size());
+    if (end > begin)
+      items.push_back(text.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return items;
+}
+
+// Parses "N", "2^N" or "2^A-B" into one or more side lengths
+inline bool parseSide(const std::string &text, std::vector<size_t> &sides) {
+  char *end = nullptr;
+  if (text.compare(0, 2, "2^") != 0) {
+    size_t side = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end || side == 0)
+      return false;
+    sides.push_back(side);
+    return true;
+  }
+
+  unsigned long first = std::strtoul(text.c_str() + 2, &end, 10), last = first;
+  if (end == text.c_str() + 2)
+    return false;
+  if (*end == '-') {
+    const char *begin = end + 1;
+    last = std::strtoul(begin, &end, 10);
+    if (end == begin)
+      return false;
+  }
+  if (*end || first > last || last >= 63)
+    return false;
+  for (unsigned long exp = first; exp <= last; ++exp)
+    sides.push_back(size_t(1) << exp);
+  return true;
+}
+
+inline bool parseSizes(const std::string &text,
+                       std::vector<std::pair<size_t, size_t>> &sizes) {
+  for (const std::string &item : splitList(text)) {
+    size_t x = item.find('x');
+    std::vector<size_t> widths, heights;
+    if (x == std::string::npos || !parseSide(item.substr(0, x), widths) ||
+        !parseSide(item.substr(x + 1), heights))
+      return false;
+    for (size_t width : widths)
+      for (size_t height : heights)
+        sizes.emplace_back(width, height);
+  }
+  return !sizes.empty();
+}
+
+// Consumes argv[i] (and its value) when it is a benchmark option. Returns
+// false for unknown options and malformed values alike.
+inline bool parseBenchOption(int argc, char *argv[], int &i,
+                             BenchOptions &options) {
+  std::string arg = argv[i];
+  if (arg == "--counters") {
+    options.counters = true;
+    return true;
+  }
+  if (i + 1 >= argc)
+    return false;
+  std::string value = argv[i + 1];
+
+  auto count = [&](auto &field, unsigned long long min) {
+    char *end = nullptr;
+    unsigned long long n = std::strtoull(value.c_str(), &end, 10);
+    if (end == value.c_str() || *end || n < min)
+      return false;
+    field = n;
+    return true;
+  };
+
+  bool valid;
+  if (arg == "--engine") {
+    options.engines = splitList(value);
+    valid = !options.engines.empty();
+  } else if (arg == "--sizes") {
+    options.sizes.clear();
+    valid = parseSizes(value, options.sizes);
+  } else if (arg == "--iterations") {
+    valid = count(options.iterations, 1);
+  } else if (arg == "--repetitions") {
+    valid = count(options.repetitions, 1);
+  } else if (arg == "--warmup") {
+    valid = count(options.warmup, 0);
+  } else if (arg == "--output") {
+    options.output = value;
+    valid = true;
+  } else if (arg == "--format") {
+    options.format = value;
+    valid = value == "csv" || value == "json";
+  } else if (arg == "--seed") {
+    valid = count(options.world.seed, 0);
+  } else if (arg == "--density") {
+    char *end = nullptr;
+    options.world.density = std::strtod(value.c_str(), &end);
+    valid = end != value.c_str() && !*end && options.world.density >= 0 &&
+            options.world.density <= 1;
+  } else if (arg == "--rng") {
+    valid = parseRandomMode(value, options.world.mode);
+  } else {
+    return false;
+  }
+  i += valid;
+  return valid;
+}
+
+// Unknown engine names are reported instead of silently running nothing
+inline bool checkEngines(const BenchOptions &options,
+                         const std::vector<std::string> &known) {
+  for (const std::string &engine : options.engines)
+    if (std::find(known.begin(), known.end(), engine) == known.end()) {
+      std::cerr << "Unknown engine " << engine << ", available:";
+      for (const std::string &name : known)
+        std::cerr << ' ' << name;
+      std::cerr << '\n';
+      return false;
+    }
+  return true;
+}
+
+inline bool benchSelected(const BenchOptions &options,
+                          const std::string &engine) {
+  return options.engines.empty() ||
+         std::find(options.engines.begin(), options.engines.end(), engine) !=
+             options.engines.end();
+}
+
+// Device timestamps of the kernels launched by one run, summed over the
+// launches. Engines without device timers report no launches.
+struct KernelTimes {
+  size_t launches = 0;
+  double queued = 0;    // Queued to submitted
+  double submitted = 0; // Submitted to started
+  double running = 0;   // Started to ended
+
+  KernelTimes &operator+=(const KernelTimes &other) {
+    launches += other.launches;
+    queued += other.queued;
+    submitted += other.submitted;
+    running += other.running;
+    return *this;
+  }
+};
+
+struct BenchSamples {
+  std::vector<double> seconds; // Per-generation latency of each repetition
+  PerfTotals counters;         // Summed over every repetition
+  std::vector<double> host;    // Host timed latency when `seconds` is not
+  KernelTimes kernels;         // Summed over every repetition
+};
+
+// Runs `prepare` and `run` warmup times untimed, then once per repetition,
+// timing only `run`. When `kernelTimes` reports launches after a run, its
+// device time replaces the host clock, which also counts launch overhead.
+template <typename Prepare, typename Run, typename Times>
+BenchSamples measure(const BenchOptions &options, size_t generations,
+                     Prepare prepare, Run run, Times kernelTimes) {
+  for (unsigned i = 0; i < options.warmup; ++i) {
+    prepare();
+    run();
+  }
+
+  BenchSamples samples;
+  std::unique_ptr<PerfCounters> counters;
+  if (options.counters)
+    counters.reset(new PerfCounters());
+  for (unsigned i = 0; i < options.repetitions; ++i) {
+    prepare();
+    if (counters)
+      counters->start();
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    if (counters)
+      counters->stop(samples.counters);
+    double seconds =
+        std::chrono::duration<double>(end - start).count() / generations;
+
+    KernelTimes kernels = kernelTimes();
+    if (kernels.launches > 0) {
+      samples.host.push_back(seconds);
+      samples.kernels += kernels;
+      seconds = kernels.running / generations;
+    }
+    samples.seconds.push_back(seconds);
+  }
+  return samples;
+}
+
+template <typename Prepare, typename Run>
+BenchSamples measure(const BenchOptions &options, size_t generations,
+                     Prepare prepare, Run run) {
+  return measure(options, generations, prepare, run,
+                 [] { return KernelTimes(); });
+}
+
+struct BenchStats {
+  double min, median, mean, p95, stddev;
+};
+
+inline BenchStats computeStats(std::vector<double> samples) {
+  if (samples.empty())
+    return {0, 0, 0, 0, 0};
+  std::sort(samples.begin(), samples.end());
+  size_t n = samples.size();
+
+  BenchStats stats;
+  stats.min = samples.front();
+  stats.median = n % 2 ? samples[n / 2]
+                       : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  double sum = 0;
+  for (double sample : samples)
+    sum += sample;
+  stats.mean = sum / n;
+  stats.p95 = samples[size_t(std::ceil(0.95 * n)) - 1]; // Nearest rank
+  double squares = 0;
+  for (double sample : samples)
+    squares += (sample - stats.mean) * (sample - stats.mean);
+  stats.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+  return stats;
+}
+
+// Collects the results of a run and writes them as CSV, with the host
+// metadata as leading "# key: value" lines, or as a single JSON document.
+// Times are kept in seconds; the CSV scales them to `timeUnit` so the plot
+// scripts keep reading the columns they expect.
+class BenchReport {
+public:
+  BenchReport(const BenchOptions &options, const std::string &defaultName,
+              const std::string &timeUnit = "s", double timeScale = 1)
+      : timeUnit(timeUnit), timeScale(timeScale) {
+    json = options.format == "json" ||
+           (options.format.empty() && options.output.size() >= 5 &&
+            options.output.compare(options.output.size() - 5, 5, ".json") ==
+                0);
+    path = !options.output.empty() ? options.output
+                                   : defaultName + (json ? ".json" : ".csv");
+
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    meta("hostname", host);
+    meta("cpu", cpuModel());
+    meta("cores", std::to_string(std::thread::hardware_concurrency()));
+#ifdef __VERSION__
+    meta("compiler", __VERSION__);
+#endif
+#ifdef __CUDACC_VER_MAJOR__
+    meta("nvcc", std::to_string(__CUDACC_VER_MAJOR__) + '.' +
+                     std::to_string(__CUDACC_VER_MINOR__));
+#endif
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    meta("date", date);
+    meta("iterations", std::to_string(options.iterations));
+    meta("repetitions", std::to_string(options.repetitions));
+    meta("warmup", std::to_string(options.warmup));
+    meta("seed", std::to_string(options.world.seed));
+    meta("density", std::to_string(options.world.density));
+    meta("rng", randomModeName(options.world.mode));
+
+    counters = options.counters;
+    if (counters) {
+      PerfCounters probe;
+      meta("counters", probe.describe());
+      if (!probe.available())
+        std::cerr << "Hardware counters " << probe.describe() << '\n';
+    }
+  }
+
+  const std::string &outputPath() const { return path; }
+
+  void meta(const std::string &key, const std::string &value) {
+    for (auto &entry : metadata)
+      if (entry.first == key) {
+        entry.second = value;
+        return;
+      }
+    metadata.emplace_back(key, value);
+  }
+
+  void add(const std::string &mode, size_t width, size_t height,
+           unsigned threads, size_t iterations, const BenchSamples &samples) {
+    rows.push_back({mode, width, height, threads, iterations,
+                    computeStats(samples.seconds), samples.counters,
+                    samples.seconds.size(), samples.kernels,
+                    computeStats(samples.host).median});
+    kernels = kernels || samples.kernels.launches > 0;
+  }
+
+  void save() const {
+    std::ofstream out(path);
+    if (!out)
+      throw std::runtime_error("[Bench] Cannot create " + path + '.');
+    if (json) {
+      out.precision(std::numeric_limits<double>::max_digits10);
+      saveJson(out);
+    } else {
+      saveCsv(out);
+    }
+    if (!out)
+      throw std::runtime_error("[Bench] Failed writing " + path + '.');
+  }
+
+private:
+  struct Row {
+    std::string mode;
+    size_t width, height;
+    unsigned threads;
+    size_t iterations;
+    BenchStats stats;
+    PerfTotals counters;
+    size_t repetitions;
+    KernelTimes kernels;
+    double hostMedian;
+  };
+
+  // Derived counter columns, NaN when an event is missing
+  struct Derived {
+    double cyclesPerCell, ipc, llcMissesPerCell, bytesPerCell,
+        branchMissesPerCell;
+  };
+
+  // The counters only follow the benchmark thread, so with more threads,
+  // processes or a device doing the work they miss most of it
+  static bool counted(const Row &row, PerfEvent event) {
+    return row.threads <= 1 && row.counters.available[event];
+  }
+
+  static Derived derive(const Row &row) {
+    const PerfTotals &c = row.counters;
+    double cells = double(row.width) * row.height * row.iterations *
+                   row.repetitions;
+    auto perCell = [&](PerfEvent event) {
+      return counted(row, event) && cells > 0 ? c.value[event] / cells : NAN;
+    };
+    Derived derived;
+    derived.cyclesPerCell = perCell(perfCycles);
+    derived.ipc = counted(row, perfCycles) &&
+                          counted(row, perfInstructions) &&
+                          c.value[perfCycles] > 0
+                      ? double(c.value[perfInstructions]) / c.value[perfCycles]
+                      : NAN;
+    derived.llcMissesPerCell = perCell(perfLlcMisses);
+    derived.bytesPerCell = derived.llcMissesPerCell * 64; // One line a miss
+    derived.branchMissesPerCell = perCell(perfBranchMisses);
+    return derived;
+  }
+
+  // Empty in CSV and null in JSON when unknown
+  static std::string number(double value, const char *empty) {
+    if (std::isnan(value))
+      return empty;
+    std::ostringstream text;
+    text.precision(6);
+    text << value;
+    return text.str();
+  }
+
+  static size_t cellsPerSecond(const Row &row) {
+    return row.stats.median > 0
+               ? std::llround(row.width * row.height / row.stats.median)
+               : 0;
+  }
+
+  static std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);)
+      if (line.compare(0, 10, "model name") == 0) {
+        size_t colon = line.find(':');
+        return colon == std::string::npos ? "" : line.substr(colon + 2);
+      }
+    return "unknown";
+  }
+
+  static std::string quote(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+      if (c == '"' || c == '\\')
+        quoted += '\\';
+      if ((unsigned char)c < 0x20)
+        quoted += ' ';
+      else
+        quoted += c;
+    }
+    return quoted + '"';
+  }
+
+  void saveCsv(std::ofstream &out) const {
+    for (const auto &entry : metadata)
+      out << "# " << entry.first << ": " << entry.second << '\n';
+
+    std::string unit = '[' + timeUnit + ']';
+    out << "Mode,Width,Height,Length,Threads,Iterations,Time" << unit
+        << ",Cells/s,Min" << unit << ",Mean" << unit << ",P95" << unit
+        << ",Stddev" << unit;
+    if (counters)
+      out << ",Cycles/cell,IPC,LLC misses/cell,Bytes/cell,Branch misses/cell";
+    if (kernels)
+      out << ",Launches,Queued" << unit << ",Submitted" << unit << ",Kernel"
+          << unit << ",Host" << unit;
+    out << '\n';
+
+    for (const Row &row : rows) {
+      out << row.mode << ',' << row.width << ',' << row.height << ','
+          << row.width * row.height << ',' << row.threads << ','
+          << row.iterations << ',' << row.stats.median * timeScale << ','
+          << cellsPerSecond(row) << ',' << row.stats.min * timeScale << ','
+          << row.stats.mean * timeScale << ',' << row.stats.p95 * timeScale
+          << ',' << row.stats.stddev * timeScale;
+      if (counters) {
+        Derived derived = derive(row);
+        out << ',' << number(derived.cyclesPerCell, "") << ','
+            << number(derived.ipc, "") << ','
+            << number(derived.llcMissesPerCell, "") << ','
+            << number(derived.bytesPerCell, "") << ','
+            << number(derived.branchMissesPerCell, "");
+      }
+      if (kernels) {
+        // Per launch, except the host time which is per generation
+        const KernelTimes &k = row.kernels;
+        double launches = k.launches ? double(k.launches) : NAN;
+        out << ',' << k.launches << ','
+            << number(k.queued / launches * timeScale, "") << ','
+            << number(k.submitted / launches * timeScale, "") << ','
+            << number(k.running / launches * timeScale, "") << ','
+            << number(k.launches ? row.hostMedian * timeScale : NAN, "");
+      }
+      out << '\n';
+    }
+  }
+
+  void saveJson(std::ofstream &out) const {
+    out << "{\n  \"host\": {";
+    for (size_t i = 0; i < metadata.size(); ++i)
+      out << (i ? ",\n    " : "\n    ") << quote(metadata[i].first) << ": "
+          << quote(metadata[i].second);
+    out << "\n  },\n  \"results\": [";
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const Row &row = rows[i];
+      out << (i ? ",\n    " : "\n    ") << "{\"mode\": " << quote(row.mode)
+          << ", \"width\": " << row.width << ", \"height\": " << row.height
+          << ", \"threads\": " << row.threads
+          << ", \"iterations\": " << row.iterations
+          << ", \"seconds\": {\"min\": " << row.stats.min
+          << ", \"median\": " << row.stats.median
+          << ", \"mean\": " << row.stats.mean << ", \"p95\": " << row.stats.p95
+          << ", \"stddev\": " << row.stats.stddev
+          << "}, \"cellsPerSecond\": " << cellsPerSecond(row);
+      if (counters) {
+        Derived derived = derive(row);
+        out << ", \"counters\": {";
+        for (int event = 0; event < perfEventCount; ++event) {
+          out << (event ? ", " : "") << quote(perfEventNames[event]) << ": ";
+          if (counted(row, PerfEvent(event)))
+            out << row.counters.value[event];
+          else
+            out << "null";
+        }
+        out << ", \"cyclesPerCell\": " << number(derived.cyclesPerCell, "null")
+            << ", \"ipc\": " << number(derived.ipc, "null")
+            << ", \"bytesPerCell\": " << number(derived.bytesPerCell, "null")
+            << ", \"branchMissesPerCell\": "
+            << number(derived.branchMissesPerCell, "null") << '}';
+      }
+      if (row.kernels.launches > 0) {
+        const KernelTimes &k = row.kernels;
+        out << ", \"kernels\": {\"launches\": " << k.launches
+            << ", \"queued\": " << k.queued << ", \"submitted\": "
+            << k.submitted << ", \"running\": " << k.running
+            << ", \"hostMedian\": " << row.hostMedian << '}';
+      }
+      out << '}';
+    }
+    out << "\n  ]\n}\n";
+  }
+
+  std::string path;
+  bool json;
+  bool counters;
+  bool kernels = false; // Some row has device timestamps
+  std::string timeUnit;
+  double timeScale;
+  std::vector<std::pair<std::string, std::string>> metadata;
+  std::vector<Row> rows;
+};
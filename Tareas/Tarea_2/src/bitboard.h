@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cycle.h"
+#include "rule.h"
+#include "stats.h"
+
+// Bit-packed rows hold 64 cells per word, bit i of word w being cell
+// 64 * w + i. Shared by the bit-packed engine and the streaming simulation.
+
+inline void fullAdder(uint64_t a, uint64_t b, uint64_t c, uint64_t &sum,
+                      uint64_t &carry) {
+  uint64_t t = a ^ b;
+  sum = t ^ c;
+  carry = (a & b) | (t & c);
+}
+
+// Next generation of `mid` into `result`, wrapping around the row ends. With
+// Hashed, the cellKey of every cell that changed is XORed into `changes`,
+// cells being numbered from `firstCell` at the start of the row. With
+// Tallied, the row's births, deaths and tile populations are added to
+// `stats`; firstCell must then be the row start. Both are template flags so
+// the plain instance keeps the bare loop.
+template <bool Hashed = false, bool Tallied = false>
+inline void computeBitboardRow(const uint64_t *up, const uint64_t *mid,
+                               const uint64_t *down, uint64_t *result,
+                               size_t wordsPerRow, const Rule &rule,
+                               uint64_t *changes = nullptr,
+                               uint64_t firstCell = 0,
+                               StatsTally *stats = nullptr) {
+  const bool conway = rule == conwayRule;
+  uint32_t *tiles = nullptr;
+  if constexpr (Tallied)
+    tiles = stats->tileRow(firstCell / (64 * wordsPerRow));
+
+  for (size_t w = 0; w < wordsPerRow; ++w) {
+    size_t w0 = (w + wordsPerRow - 1) % wordsPerRow;
+    size_t w2 = (w + 1) % wordsPerRow;
+
+    // West neighbours shift towards the high bits and take the top bit of
+    // the previous word, east neighbours the other way round.
+    uint64_t upW = (up[w] << 1) | (up[w0] >> 63);
+    uint64_t upE = (up[w] >> 1) | (up[w2] << 63);
+    uint64_t midW = (mid[w] << 1) | (mid[w0] >> 63);
+    uint64_t midE = (mid[w] >> 1) | (mid[w2] << 63);
+    uint64_t downW = (down[w] << 1) | (down[w0] >> 63);
+    uint64_t downE = (down[w] >> 1) | (down[w2] << 63);
+
+    // Sum the eight neighbour planes into the bits of a 64-lane counter.
+    uint64_t upOnes, upTwos, downOnes, downTwos;
+    fullAdder(upW, up[w], upE, upOnes, upTwos);
+    fullAdder(downW, down[w], downE, downOnes, downTwos);
+    uint64_t midOnes = midW ^ midE;
+    uint64_t midTwos = midW & midE;
+
+    uint64_t ones, onesCarry, twos, twosCarry;
+    fullAdder(upOnes, downOnes, midOnes, ones, onesCarry);
+    fullAdder(upTwos, downTwos, midTwos, twos, twosCarry);
+    uint64_t bit1 = twos ^ onesCarry;
+    uint64_t bit2 = twosCarry ^ (twos & onesCarry);
+
+    uint64_t next = 0;
+    if (conway) {
+      // 2 or 3 neighbours have bit 1 set and bit 2 clear, 8 wraps to 0.
+      next = bit1 & ~bit2 & (ones | mid[w]);
+    } else {
+      // Other rules match every neighbour count they use bit by bit
+      uint64_t bit3 = twosCarry & twos & onesCarry;
+      for (int n = 0; n <= 8; ++n) {
+        bool born = rule.birth >> n & 1, survives = rule.survival >> n & 1;
+        if (!born && !survives)
+          continue;
+        uint64_t count = (n & 1 ? ones : ~ones) & (n & 2 ? bit1 : ~bit1) &
+                         (n & 4 ? bit2 : ~bit2) & (n & 8 ? bit3 : ~bit3);
+        next |= count & (born && survives ? ~0ull : born ? ~mid[w] : mid[w]);
+      }
+    }
+
+    if constexpr (Hashed)
+      *changes ^= changedBitsKey(next ^ mid[w], firstCell + 64 * w);
+    if constexpr (Tallied) {
+      stats->births += __builtin_popcountll(next & ~mid[w]);
+      stats->deaths += __builtin_popcountll(mid[w] & ~next);
+      tiles[64 * w / statsTileSize] += __builtin_popcountll(next);
+    }
+    result[w] = next;
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "rule.h"
+
+// The block engine stores the world as 2x2 blocks of cells, one block per
+// byte with bit 2 * y + x holding cell (x, y) of the block. A block's next
+// state depends only on the 4x4 cells around it, so it is looked up in a
+// table indexed by those 16 cells, bit 4 * y + x holding cell (x, y) of the
+// neighbourhood. The block itself sits at (1, 1)..(2, 2).
+typedef std::array<uint8_t, 65536> BlockTable;
+
+// Built at run time: the 65536 entries are far past what compilers allow in
+// a constant expression.
+inline void makeBlockTable(BlockTable &table, const Rule &rule) {
+  // Neighbours of the cell at (1, 1), the others are shifts of it
+  const uint32_t around = 0x0757;
+
+  for (uint32_t cells = 0; cells < 65536; ++cells) {
+    uint8_t block = 0;
+    for (int cell = 0; cell < 4; ++cell) {
+      int shift = cell / 2 * 4 + cell % 2;
+      int alive = __builtin_popcount(cells & around << shift);
+      bool self = cells >> (shift + 5) & 1;
+      block |= ((self ? rule.survival : rule.birth) >> alive & 1) << cell;
+    }
+    table[cells] = block;
+  }
+}
+
+// The 4 cells of row `half` (0 top, 1 bottom) of three neighbouring blocks
+// that touch the middle one: the right column of `left`, both cells of
+// `mid` and the left column of `right`.
+inline uint32_t blockRow(uint32_t left, uint32_t mid, uint32_t right,
+                         int half) {
+  int shift = 2 * half;
+  return (left >> (shift + 1) & 1) | (mid >> shift & 3) << 1 |
+         (right >> shift & 1) << 3;
+}
+
+// Table index of the block in the middle of three rows of three blocks
+inline uint32_t blockIndex(uint32_t upLeft, uint32_t up, uint32_t upRight,
+                           uint32_t left, uint32_t mid, uint32_t right,
+                           uint32_t downLeft, uint32_t down,
+                           uint32_t downRight) {
+  return blockRow(upLeft, up, upRight, 1) |
+         blockRow(left, mid, right, 0) << 4 |
+         blockRow(left, mid, right, 1) << 8 |
+         blockRow(downLeft, down, downRight, 0) << 12;
+}
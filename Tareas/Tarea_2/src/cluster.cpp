@@ -0,0 +1,281 @@
+#include "cluster.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+enum Op : uint32_t { opLoad, opStep, opStore, opStop };
+
+size_t roundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Waiters spin briefly, then sleep on the word with a futex. The futexes
+// are not private, so they work across processes sharing the mapping.
+void waitWhile(std::atomic<uint32_t> &word, uint32_t value) {
+  for (int spin = 0; spin < 1024; ++spin)
+    if (word.load(std::memory_order_acquire) != value)
+      return;
+  while (word.load(std::memory_order_acquire) == value)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, value,
+            nullptr, nullptr, 0);
+}
+
+void wakeAll(std::atomic<uint32_t> &word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+// Single producer, single consumer ring of rows. The counters only grow and
+// wrap around together, so head - tail is the number of rows queued.
+struct RingHeader {
+  alignas(64) std::atomic<uint32_t> head; // Rows written
+  alignas(64) std::atomic<uint32_t> tail; // Rows read
+};
+
+class Ring {
+public:
+  Ring(ubyte *memory, size_t slots, size_t width)
+      : header(reinterpret_cast<RingHeader *>(memory)),
+        rows(memory + sizeof(RingHeader)), slots(slots), width(width) {}
+
+  void push(const ubyte *row) {
+    uint32_t head = header->head.load(std::memory_order_relaxed);
+    uint32_t tail;
+    while (head - (tail = header->tail.load(std::memory_order_acquire)) ==
+           slots)
+      waitWhile(header->tail, tail);
+    std::memcpy(rows + head % slots * width, row, width);
+    header->head.store(head + 1, std::memory_order_release);
+    wakeAll(header->head);
+  }
+
+  void pop(ubyte *row) {
+    uint32_t tail = header->tail.load(std::memory_order_relaxed);
+    uint32_t head;
+    while ((head = header->head.load(std::memory_order_acquire)) == tail)
+      waitWhile(header->head, head);
+    std::memcpy(row, rows + tail % slots * width, width);
+    header->tail.store(tail + 1, std::memory_order_release);
+    wakeAll(header->tail);
+  }
+
+private:
+  RingHeader *header;
+  ubyte *rows;
+  size_t slots, width;
+};
+
+// Rings 2 i and 2 i + 1 carry the rows coming into strip i from above and
+// from below.
+class ShmTransport : public HaloTransport {
+public:
+  ShmTransport(ubyte *rings, size_t ringBytes, size_t slots, size_t width,
+               unsigned id, unsigned processes)
+      : up(ring(rings, ringBytes, slots, width,
+                2 * ((id + processes - 1) % processes) + 1)),
+        down(ring(rings, ringBytes, slots, width,
+                  2 * ((id + 1) % processes))),
+        above(ring(rings, ringBytes, slots, width, 2 * id)),
+        below(ring(rings, ringBytes, slots, width, 2 * id + 1)) {}
+
+  void sendUp(const ubyte *row) override { up.push(row); }
+  void sendDown(const ubyte *row) override { down.push(row); }
+  void receiveFromAbove(ubyte *row) override { above.pop(row); }
+  void receiveFromBelow(ubyte *row) override { below.pop(row); }
+
+private:
+  static Ring ring(ubyte *rings, size_t ringBytes, size_t slots, size_t width,
+                   size_t index) {
+    return Ring(rings + index * ringBytes, slots, width);
+  }
+
+  Ring up, down, above, below;
+};
+
+} // namespace
+
+void Strip::computeRow(ptrdiff_t y) {
+  kernel(cells.row(y - 1).cells - 1, cells.row(y).cells - 1,
+         cells.row(y + 1).cells - 1, next.row(y).cells - 1, cells.width);
+}
+
+void Strip::step(HaloTransport &transport) {
+  const ptrdiff_t height = cells.height;
+  transport.sendUp(cells.row(0).cells);
+  transport.sendDown(cells.row(height - 1).cells);
+
+  for (ptrdiff_t y = 0; y < height; ++y)
+    cells.wrapRow(y);
+  for (ptrdiff_t y = 1; y < height - 1; ++y)
+    computeRow(y);
+
+  transport.receiveFromAbove(cells.row(-1).cells);
+  transport.receiveFromBelow(cells.row(height).cells);
+  cells.wrapRow(-1);
+  cells.wrapRow(height);
+  computeRow(0);
+  if (height > 1)
+    computeRow(height - 1);
+
+  cells.swap(next);
+}
+
+struct ProcessCluster::Control {
+  alignas(64) std::atomic<uint32_t> sequence; // Bumped for every command
+  uint32_t op;
+  uint64_t generations;
+  alignas(64) std::atomic<uint32_t> done; // Workers through the command
+  std::atomic<uint32_t> failed;
+};
+
+ProcessCluster::ProcessCluster(size_t width, size_t height,
+                               unsigned processes, RowKernel kernel,
+                               size_t ringSlots)
+    : width(width), height(height), processes(processes),
+      ringSlots(ringSlots) {
+  if (processes == 0 || height < processes)
+    throw std::logic_error("[Cluster] Every process needs at least one row.");
+
+  ringBytes = sizeof(RingHeader) + roundUp(ringSlots * width, 64);
+  size_t ringsOffset = roundUp(sizeof(Control), 64);
+  size_t worldOffset = ringsOffset + 2 * processes * ringBytes;
+  mappedBytes = worldOffset + width * height;
+
+  // The name is only needed until the workers inherit the mapping
+  static std::atomic<unsigned> clusters{0};
+  std::string name = "/life-cluster-" + std::to_string(getpid()) + '-' +
+                     std::to_string(clusters++);
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+    throw std::runtime_error("[Cluster] Cannot create shared memory " + name +
+                             ": " + std::strerror(errno) + '.');
+  shm_unlink(name.c_str());
+  if (ftruncate(fd, mappedBytes) != 0) {
+    close(fd);
+    throw std::runtime_error("[Cluster] Cannot grow shared memory to " +
+                             std::to_string(mappedBytes) + " bytes.");
+  }
+  void *memory =
+      mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+    throw std::runtime_error("[Cluster] Cannot map shared memory.");
+
+  shared = static_cast<ubyte *>(memory);
+  control = new (shared) Control();
+  for (size_t i = 0; i < 2 * processes; ++i)
+    new (shared + ringsOffset + i * ringBytes) RingHeader();
+  world = shared + worldOffset;
+
+  for (unsigned id = 0; id < processes; ++id) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      workerLoop(id, kernel);
+      _exit(0);
+    }
+    if (pid < 0) {
+      shutdown();
+      throw std::runtime_error("[Cluster] Cannot start worker process.");
+    }
+    workers.push_back(pid);
+  }
+}
+
+ProcessCluster::~ProcessCluster() { shutdown(); }
+
+void ProcessCluster::shutdown() {
+  if (!shared)
+    return;
+  // After a failure the others may be stuck waiting for the failed worker's
+  // rows, so they are killed instead.
+  control->op = opStop;
+  control->sequence.fetch_add(1, std::memory_order_release);
+  wakeAll(control->sequence);
+  bool failed = control->failed.load(std::memory_order_acquire);
+  for (pid_t pid : workers) {
+    if (failed)
+      kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+  workers.clear();
+  munmap(shared, mappedBytes);
+  shared = nullptr;
+}
+
+void ProcessCluster::load(const ubyte *data) {
+  std::memcpy(world, data, width * height);
+  command(opLoad);
+}
+
+void ProcessCluster::step(size_t generations) { command(opStep, generations); }
+
+void ProcessCluster::store(ubyte *data) {
+  command(opStore);
+  std::memcpy(data, world, width * height);
+}
+
+void ProcessCluster::command(uint32_t op, size_t generations) {
+  control->op = op;
+  control->generations = generations;
+  control->done.store(0, std::memory_order_relaxed);
+  control->sequence.fetch_add(1, std::memory_order_release);
+  wakeAll(control->sequence);
+
+  uint32_t done;
+  while ((done = control->done.load(std::memory_order_acquire)) < processes &&
+         !control->failed.load(std::memory_order_acquire))
+    waitWhile(control->done, done);
+  if (control->failed.load(std::memory_order_acquire))
+    throw std::runtime_error("[Cluster] A worker process failed.");
+}
+
+void ProcessCluster::workerLoop(unsigned id, RowKernel kernel) {
+  size_t first = height * id / processes;
+  size_t rows = height * (id + 1) / processes - first;
+  ubyte *rings = shared + roundUp(sizeof(Control), 64);
+  uint32_t seen = 0;
+
+  try {
+    Strip strip(width, rows, kernel);
+    ShmTransport transport(rings, ringBytes, ringSlots, width, id, processes);
+
+    while (true) {
+      waitWhile(control->sequence, seen);
+      seen = control->sequence.load(std::memory_order_acquire);
+
+      if (control->op == opStop)
+        return;
+      if (control->op == opLoad)
+        strip.cells.load(world + first * width);
+      if (control->op == opStore)
+        strip.cells.store(world + first * width);
+      for (size_t g = 0; control->op == opStep && g < control->generations;
+           ++g)
+        strip.step(transport);
+
+      if (control->done.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+          processes)
+        wakeAll(control->done);
+    }
+  } catch (const std::exception &) {
+    control->failed.store(1, std::memory_order_release);
+    control->done.fetch_add(1, std::memory_order_acq_rel);
+    wakeAll(control->done);
+    _exit(1);
+  }
+}
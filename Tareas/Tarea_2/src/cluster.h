@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+#include "grid.h"
+
+// Domain decomposition over local worker processes. The world is cut into
+// horizontal strips, one per process, and every generation each strip
+// trades its edge rows with the strips above and below (wrapping around).
+//
+// Strips only talk to their neighbours through HaloTransport, so the
+// stepping code does not know how rows travel. ShmTransport moves them
+// through POSIX shared memory rings between processes of one machine; a
+// socket or MPI transport would implement the same four calls and launch
+// its workers elsewhere.
+
+// Same signature as the SIMD row kernels in serial.cpp. Row pointers start
+// at the left ghost column, cell x lives at index x + 1.
+typedef void (*RowKernel)(const ubyte *up, const ubyte *mid,
+                          const ubyte *down, ubyte *result, size_t width);
+
+class HaloTransport {
+public:
+  virtual ~HaloTransport() = default;
+
+  // Hand this strip's top row to the strip above, or its bottom row to the
+  // strip below. May return before the row arrives.
+  virtual void sendUp(const ubyte *row) = 0;
+  virtual void sendDown(const ubyte *row) = 0;
+
+  // Block until the bottom row of the strip above, or the top row of the
+  // strip below, arrives.
+  virtual void receiveFromAbove(ubyte *row) = 0;
+  virtual void receiveFromBelow(ubyte *row) = 0;
+};
+
+// One strip and the generation after it. The halo rows are sent first and
+// the interior computed while they travel, the edge rows wait for the
+// neighbours' rows.
+class Strip {
+public:
+  Strip(size_t width, size_t height, RowKernel kernel)
+      : cells(width, height), next(width, height), kernel(kernel) {}
+
+  void step(HaloTransport &transport);
+
+  Grid cells;
+
+private:
+  void computeRow(ptrdiff_t y);
+
+  Grid next;
+  RowKernel kernel;
+};
+
+// Runs `processes` forked workers over one world. load, step and store are
+// collective: the caller blocks until every worker is done. Workers read
+// the rule and row kernel as they were when the cluster was created.
+class ProcessCluster {
+public:
+  ProcessCluster(size_t width, size_t height, unsigned processes,
+                 RowKernel kernel, size_t ringSlots = 4);
+  ~ProcessCluster();
+
+  ProcessCluster(const ProcessCluster &) = delete;
+  ProcessCluster &operator=(const ProcessCluster &) = delete;
+
+  void load(const ubyte *data);
+  void step(size_t generations);
+  void store(ubyte *data);
+
+  unsigned size() const { return processes; }
+
+private:
+  struct Control;
+
+  void command(uint32_t op, size_t generations = 0);
+  void shutdown();
+  void workerLoop(unsigned id, RowKernel kernel);
+
+  size_t width, height;
+  unsigned processes;
+  size_t ringSlots;
+  size_t ringBytes;
+  size_t mappedBytes = 0;
+  ubyte *shared = nullptr;
+  Control *control = nullptr;
+  ubyte *world = nullptr; // Shared copy used by load and store
+  std::vector<pid_t> workers;
+};
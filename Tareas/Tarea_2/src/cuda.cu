@@ -2,32 +2,33 @@
 
 typedef unsigned char ubyte;
 
-__global__ void fillRandomLifeData(ubyte *lifeData, size_t size,
-                                   unsigned int seed) {
-  int idx = blockIdx.x * blockDim.x + threadIdx.x;
-  for (size_t i = idx; i < size; i += blockDim.x * gridDim.x) {
-    unsigned int x = i ^ seed;
-    x = (x * 1664525u + 1013904223u);
-    lifeData[i] = (x >> 24) & 1;
-  }
+// Bit n is set when n alive neighbours give birth or survival, B3/S23 by
+// default. Set from the host with setLifeRule.
+__constant__ unsigned short c_birthMask = 0x008;
+__constant__ unsigned short c_survivalMask = 0x00C;
+
+void setLifeRule(unsigned short birth, unsigned short survival) {
+  cudaMemcpyToSymbol(c_birthMask, &birth, sizeof(birth));
+  cudaMemcpyToSymbol(c_survivalMask, &survival, sizeof(survival));
 }
 
 __global__ void simpleLifeKernel(volatile const ubyte *lifeData,
-                                 uint worldWidth, uint worldHeight,
+                                 size_t worldWidth, size_t worldHeight,
                                  ubyte *resultLifeData) {
-  uint worldSize = worldWidth * worldHeight;
+  size_t worldSize = worldWidth * worldHeight;
 
-  for (uint cellId = blockIdx.x * blockDim.x + threadIdx.x; cellId < worldSize;
+  for (size_t cellId = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+       cellId < worldSize;
        cellId += blockDim.x * gridDim.x) {
 
-    uint x = cellId % worldWidth;
-    uint yAbs = cellId - x;
+    size_t x = cellId % worldWidth;
+    size_t yAbs = cellId - x;
 
-    uint xLeft = (x + worldWidth - 1) % worldWidth;
-    uint xRight = (x + 1) % worldWidth;
+    size_t xLeft = (x + worldWidth - 1) % worldWidth;
+    size_t xRight = (x + 1) % worldWidth;
 
-    uint yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
-    uint yAbsDown = (yAbs + worldWidth) % worldSize;
+    size_t yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
+    size_t yAbsDown = (yAbs + worldWidth) % worldSize;
 
     uint aliveCells = lifeData[xLeft + yAbsUp] + lifeData[x + yAbsUp] +
                       lifeData[xRight + yAbsUp] + lifeData[xLeft + yAbs] +
@@ -35,26 +36,28 @@ __global__ void simpleLifeKernel(volatile const ubyte *lifeData,
                       lifeData[x + yAbsDown] + lifeData[xRight + yAbsDown];
 
     resultLifeData[x + yAbs] =
-        aliveCells == 3 || (aliveCells == 2 && lifeData[x + yAbs]) ? 1 : 0;
+        ((lifeData[x + yAbs] ? c_survivalMask : c_birthMask) >> aliveCells) &
+        1;
   }
 }
 
 __global__ void simpleLifeKernelIfs(volatile const ubyte *lifeData,
-                                    uint worldWidth, uint worldHeight,
+                                    size_t worldWidth, size_t worldHeight,
                                     ubyte *resultLifeData) {
-  uint worldSize = worldWidth * worldHeight;
+  size_t worldSize = worldWidth * worldHeight;
 
-  for (uint cellId = blockIdx.x * blockDim.x + threadIdx.x; cellId < worldSize;
+  for (size_t cellId = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+       cellId < worldSize;
        cellId += blockDim.x * gridDim.x) {
 
-    uint x = cellId % worldWidth;
-    uint yAbs = cellId - x;
+    size_t x = cellId % worldWidth;
+    size_t yAbs = cellId - x;
 
-    uint xLeft = (x + worldWidth - 1) % worldWidth;
-    uint xRight = (x + 1) % worldWidth;
+    size_t xLeft = (x + worldWidth - 1) % worldWidth;
+    size_t xRight = (x + 1) % worldWidth;
 
-    uint yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
-    uint yAbsDown = (yAbs + worldWidth) % worldSize;
+    size_t yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
+    size_t yAbsDown = (yAbs + worldWidth) % worldSize;
 
     uint aliveCells = 0;
     if (lifeData[xLeft + yAbsUp])
@@ -74,26 +77,55 @@ __global__ void simpleLifeKernelIfs(volatile const ubyte *lifeData,
     if (lifeData[xRight + yAbsDown])
       aliveCells += 1;
 
-    if (aliveCells == 3 || (aliveCells == 2 && lifeData[x + yAbs]))
+    if (((lifeData[x + yAbs] ? c_survivalMask : c_birthMask) >> aliveCells) &
+        1)
       resultLifeData[x + yAbs] = 1;
     else
       resultLifeData[x + yAbs] = 0;
   }
 }
 
-__global__ void simpleLifeKernel2D(volatile ubyte *const *lifeData,
-                                   uint worldWidth, uint worldHeight,
+// Rows are `pitch` bytes apart, as laid out by cudaMallocPitch
+__global__ void simpleLifeKernel2D(volatile const ubyte *lifeData,
+                                   size_t pitch, size_t worldWidth,
+                                   size_t worldHeight,
+                                   ubyte *resultLifeData) {
+  size_t x = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (x >= worldWidth || y >= worldHeight)
+    return;
+
+  size_t xLeft = (x + worldWidth - 1) % worldWidth;
+  size_t xRight = (x + 1) % worldWidth;
+  size_t yUp = (y + worldHeight - 1) % worldHeight;
+  size_t yDown = (y + 1) % worldHeight;
+
+  volatile const ubyte *up = lifeData + yUp * pitch;
+  volatile const ubyte *mid = lifeData + y * pitch;
+  volatile const ubyte *down = lifeData + yDown * pitch;
+
+  uint aliveCells = up[xLeft] + up[x] + up[xRight] + mid[xLeft] + mid[xRight] +
+                    down[xLeft] + down[x] + down[xRight];
+
+  resultLifeData[y * pitch + x] =
+      ((mid[x] ? c_survivalMask : c_birthMask) >> aliveCells) & 1;
+}
+
+// Array of row pointers, kept to compare against the pitched layout
+__global__ void simpleLifeKernelRows2D(volatile ubyte *const *lifeData,
+                                   size_t worldWidth, size_t worldHeight,
                                    ubyte **resultLifeData) {
-  uint x = blockIdx.x * blockDim.x + threadIdx.x;
-  uint y = blockIdx.y * blockDim.y + threadIdx.y;
+  size_t x = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t y = blockIdx.y * blockDim.y + threadIdx.y;
 
   if (x >= worldWidth || y >= worldHeight)
     return;
 
-  uint xLeft = (x + worldWidth - 1) % worldWidth;
-  uint xRight = (x + 1) % worldWidth;
-  uint yUp = (y + worldHeight - 1) % worldHeight;
-  uint yDown = (y + 1) % worldHeight;
+  size_t xLeft = (x + worldWidth - 1) % worldWidth;
+  size_t xRight = (x + 1) % worldWidth;
+  size_t yUp = (y + worldHeight - 1) % worldHeight;
+  size_t yDown = (y + 1) % worldHeight;
 
   uint aliveCells = lifeData[yUp][xLeft] + lifeData[yUp][x] +
                     lifeData[yUp][xRight] + lifeData[y][xLeft] +
@@ -101,13 +133,14 @@ __global__ void simpleLifeKernel2D(volatile ubyte *const *lifeData,
                     lifeData[yDown][x] + lifeData[yDown][xRight];
 
   resultLifeData[y][x] =
-      (aliveCells == 3 || (aliveCells == 2 && lifeData[y][x])) ? 1 : 0;
+      ((lifeData[y][x] ? c_survivalMask : c_birthMask) >> aliveCells) & 1;
 }
 
 void runSimpleLifeKernel(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
                          size_t worldWidth, size_t worldHeight,
-                         size_t iterationsCount, ushort threadsCount) {
-  size_t reqBlocksCount = (worldWidth * worldHeight) / threadsCount;
+                         size_t iterationsCount, unsigned threadsCount) {
+  size_t reqBlocksCount =
+      (worldWidth * worldHeight + threadsCount - 1) / threadsCount;
   ushort blocksCount = (ushort)std::min((size_t)32768, reqBlocksCount);
 
   for (size_t i = 0; i < iterationsCount; ++i) {
@@ -120,8 +153,9 @@ void runSimpleLifeKernel(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
 
 void runSimpleLifeKernelIfs(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
                             size_t worldWidth, size_t worldHeight,
-                            size_t iterationsCount, ushort threadsCount) {
-  size_t reqBlocksCount = (worldWidth * worldHeight) / threadsCount;
+                            size_t iterationsCount, unsigned threadsCount) {
+  size_t reqBlocksCount =
+      (worldWidth * worldHeight + threadsCount - 1) / threadsCount;
   ushort blocksCount = (ushort)std::min((size_t)32768, reqBlocksCount);
 
   for (size_t i = 0; i < iterationsCount; ++i) {
@@ -132,15 +166,30 @@ void runSimpleLifeKernelIfs(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
   cudaDeviceSynchronize();
 }
 
-void runSimpleLifeKernel2D(ubyte **&d_lifeData, ubyte **&d_lifeDataBuffer,
-                           size_t worldWidth, size_t worldHeight,
-                           size_t iterationsCount, ushort threadsCount) {
+void runSimpleLifeKernel2D(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
+                           size_t pitch, size_t worldWidth, size_t worldHeight,
+                           size_t iterationsCount, unsigned threadsCount) {
   dim3 threadsPerBlock(16, 16);
   dim3 numBlocks((worldWidth + threadsPerBlock.x - 1) / threadsPerBlock.x,
                  (worldHeight + threadsPerBlock.y - 1) / threadsPerBlock.y);
 
   for (size_t i = 0; i < iterationsCount; ++i) {
     simpleLifeKernel2D<<<numBlocks, threadsPerBlock>>>(
+        d_lifeData, pitch, worldWidth, worldHeight, d_lifeDataBuffer);
+    std::swap(d_lifeData, d_lifeDataBuffer);
+  }
+  cudaDeviceSynchronize();
+}
+
+void runSimpleLifeKernelRows2D(ubyte **&d_lifeData, ubyte **&d_lifeDataBuffer,
+                               size_t worldWidth, size_t worldHeight,
+                               size_t iterationsCount, unsigned threadsCount) {
+  dim3 threadsPerBlock(16, 16);
+  dim3 numBlocks((worldWidth + threadsPerBlock.x - 1) / threadsPerBlock.x,
+                 (worldHeight + threadsPerBlock.y - 1) / threadsPerBlock.y);
+
+  for (size_t i = 0; i < iterationsCount; ++i) {
+    simpleLifeKernelRows2D<<<numBlocks, threadsPerBlock>>>(
         d_lifeData, worldWidth, worldHeight, d_lifeDataBuffer);
     std::swap(d_lifeData, d_lifeDataBuffer);
   }
@@ -0,0 +1,191 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "engine.h"
+
+void runSimpleLifeKernel(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
+                         size_t worldWidth, size_t worldHeight,
+                         size_t iterationsCount, unsigned threadsCount);
+
+void runSimpleLifeKernelIfs(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
+                            size_t worldWidth, size_t worldHeight,
+                            size_t iterationsCount, unsigned threadsCount);
+
+void runSimpleLifeKernel2D(ubyte *&d_lifeData, ubyte *&d_lifeDataBuffer,
+                           size_t pitch, size_t worldWidth, size_t worldHeight,
+                           size_t iterationsCount, unsigned threadsCount);
+
+void runSimpleLifeKernelRows2D(ubyte **&d_lifeData, ubyte **&d_lifeDataBuffer,
+                               size_t worldWidth, size_t worldHeight,
+                               size_t iterationsCount, unsigned threadsCount);
+
+void setLifeRule(unsigned short birth, unsigned short survival);
+
+#define CHECK_CUDA_ERROR(err, msg)                                             \
+  if (err != cudaSuccess)                                                      \
+    throw std::runtime_error(std::string("[CUDA] ") + cudaGetErrorString(err) \
+                             + " " + msg + '.');
+
+// The 1D kernels walk a flat buffer and the 2D kernel a pitched one from
+// cudaMallocPitch. The rows kernel goes through a device array of row
+// pointers into a flat buffer, the layout the 2D kernel replaced.
+class CudaEngine : public LifeEngine {
+public:
+  enum Kernel { plain, ifs, twoD, rows2D };
+
+  CudaEngine(const char *title, Kernel kernel, const EngineOptions &options)
+      : title(title), kernel(kernel),
+        threadsCount(options.threads ? options.threads : 256) {
+    setLifeRule(options.rule.birth, options.rule.survival);
+
+    cudaDeviceProp properties;
+    CHECK_CUDA_ERROR(cudaGetDeviceProperties(&properties, 0),
+                     "reading device properties");
+    deviceName = properties.name;
+    if (threads() > unsigned(properties.maxThreadsPerBlock))
+      throw std::logic_error("[CUDA] " + this->title + " runs at most " +
+                             std::to_string(properties.maxThreadsPerBlock) +
+                             " threads per block.");
+  }
+
+  ~CudaEngine() override { release(); }
+
+  std::string name() const override { return title; }
+
+  void load(const ubyte *data, size_t width, size_t height) override {
+    if (width != worldWidth || height != worldHeight) {
+      release();
+      worldWidth = width;
+      worldHeight = height;
+      allocate();
+    }
+    CHECK_CUDA_ERROR(cudaMemcpy2D(d_lifeDataRows, pitch, data, worldWidth,
+                                  worldWidth, worldHeight,
+                                  cudaMemcpyHostToDevice),
+                     "writing world");
+    d_lifeData = d_lifeDataRows;
+    d_lifeDataBuffer = d_lifeDataBufferRows;
+    d_rows = d_rowsFront;
+    d_rowsBuffer = d_rowsBack;
+  }
+
+  void step(size_t generations) override {
+    if (kernel == twoD)
+      runSimpleLifeKernel2D(d_lifeData, d_lifeDataBuffer, pitch, worldWidth,
+                            worldHeight, generations, threadsCount);
+    else if (kernel == rows2D)
+      runSimpleLifeKernelRows2D(d_rows, d_rowsBuffer, worldWidth, worldHeight,
+                                generations, threadsCount);
+    else if (kernel == ifs)
+      runSimpleLifeKernelIfs(d_lifeData, d_lifeDataBuffer, worldWidth,
+                             worldHeight, generations, threadsCount);
+    else
+      runSimpleLifeKernel(d_lifeData, d_lifeDataBuffer, worldWidth,
+                          worldHeight, generations, threadsCount);
+    CHECK_CUDA_ERROR(cudaGetLastError(), "running kernel");
+  }
+
+  void readback(ubyte *data) override {
+    // The rows kernel swaps the row arrays, which point at either buffer
+    const ubyte *current = d_lifeData;
+    if (kernel == rows2D)
+      current = d_rows == d_rowsFront ? d_lifeDataRows : d_lifeDataBufferRows;
+    CHECK_CUDA_ERROR(cudaMemcpy2D(data, worldWidth, current, pitch, worldWidth,
+                                  worldHeight, cudaMemcpyDeviceToHost),
+                     "reading world");
+  }
+
+  // The 2D kernels always run 16x16 blocks
+  unsigned threads() const override {
+    return kernel == twoD || kernel == rows2D ? 256 : threadsCount;
+  }
+  std::string device() const override { return deviceName; }
+
+private:
+  size_t size() const { return worldWidth * worldHeight; }
+
+  void allocate() {
+    if (kernel == twoD) {
+      // Both buffers share the same width, so they get the same pitch
+      CHECK_CUDA_ERROR(cudaMallocPitch(&d_lifeDataRows, &pitch,
+                                       worldWidth * sizeof(ubyte),
+                                       worldHeight),
+                       "allocating world");
+      CHECK_CUDA_ERROR(cudaMallocPitch(&d_lifeDataBufferRows, &pitch,
+                                       worldWidth * sizeof(ubyte),
+                                       worldHeight),
+                       "allocating world");
+      return;
+    }
+
+    pitch = worldWidth;
+    CHECK_CUDA_ERROR(cudaMalloc(&d_lifeDataRows, size() * sizeof(ubyte)),
+                     "allocating world");
+    CHECK_CUDA_ERROR(cudaMalloc(&d_lifeDataBufferRows, size() * sizeof(ubyte)),
+                     "allocating world");
+    if (kernel != rows2D)
+      return;
+
+    CHECK_CUDA_ERROR(cudaMalloc(&d_rowsFront, worldHeight * sizeof(ubyte *)),
+                     "allocating rows");
+    CHECK_CUDA_ERROR(cudaMalloc(&d_rowsBack, worldHeight * sizeof(ubyte *)),
+                     "allocating rows");
+    std::vector<ubyte *> h_rows(worldHeight), h_rowsBuffer(worldHeight);
+    for (size_t i = 0; i < worldHeight; ++i) {
+      h_rows[i] = d_lifeDataRows + i * worldWidth;
+      h_rowsBuffer[i] = d_lifeDataBufferRows + i * worldWidth;
+    }
+    cudaMemcpy(d_rowsFront, h_rows.data(), worldHeight * sizeof(ubyte *),
+               cudaMemcpyHostToDevice);
+    cudaMemcpy(d_rowsBack, h_rowsBuffer.data(), worldHeight * sizeof(ubyte *),
+               cudaMemcpyHostToDevice);
+  }
+
+  void release() {
+    cudaFree(d_lifeDataRows);
+    cudaFree(d_lifeDataBufferRows);
+    cudaFree(d_rowsFront);
+    cudaFree(d_rowsBack);
+    d_lifeDataRows = d_lifeDataBufferRows = nullptr;
+    d_rowsFront = d_rowsBack = nullptr;
+  }
+
+  std::string title;
+  Kernel kernel;
+  unsigned threadsCount;
+  std::string deviceName;
+  size_t worldWidth = 0;
+  size_t worldHeight = 0;
+  size_t pitch = 0; // Bytes between rows
+
+  ubyte *d_lifeDataRows = nullptr; // Owned buffers
+  ubyte *d_lifeDataBufferRows = nullptr;
+  ubyte **d_rowsFront = nullptr;
+  ubyte **d_rowsBack = nullptr;
+
+  ubyte *d_lifeData = nullptr; // Current and next generation
+  ubyte *d_lifeDataBuffer = nullptr;
+  ubyte **d_rows = nullptr;
+  ubyte **d_rowsBuffer = nullptr;
+};
+
+static const bool cudaEnginesRegistered = [] {
+  registerEngine("cuda", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new CudaEngine("CUDA", CudaEngine::plain, options));
+  });
+  registerEngine("cuda-ifs", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new CudaEngine("CUDA Ifs", CudaEngine::ifs, options));
+  });
+  registerEngine("cuda-2d", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new CudaEngine("CUDA 2D", CudaEngine::twoD, options));
+  });
+  registerEngine("cuda-2d-rows", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new CudaEngine("CUDA 2D Rows", CudaEngine::rows2D, options));
+  });
+  return true;
+}();
@@ -0,0 +1,61 @@
+#include "cycle.h"
+
+#include <algorithm>
+
+uint64_t worldHash(const ubyte *data, size_t size) {
+  uint64_t hash = 0;
+  for (size_t i = 0; i < size; ++i)
+    if (data[i])
+      hash ^= cellKey(i);
+  return hash;
+}
+
+void CycleWatch::observe(uint64_t generation, uint64_t hash) {
+  size_t slots = recent.size();
+  if (!enabled() || found())
+    return;
+
+  // The smallest period is the one the world actually repeats with
+  if (!checking) {
+    for (size_t p = 1; p <= std::min(stored, slots); ++p) {
+      if (recent[(generation - p) % slots] != hash)
+        continue;
+      firstRepeat = generation;
+      period = p;
+      checking = options.verify;
+      held.clear();
+      break;
+    }
+  }
+
+  recent[generation % slots] = hash;
+  stored = std::min(stored + 1, slots);
+}
+
+uint64_t CycleWatch::wantsWorld() const {
+  if (!checking)
+    return 0;
+  return held.empty() ? firstRepeat : heldGeneration + period;
+}
+
+void CycleWatch::offer(uint64_t generation, const ubyte *data, size_t size) {
+  if (!checking)
+    return;
+  if (held.empty()) {
+    // Batched engines may only hand over a later generation, which repeats
+    // with the same period if the match was real.
+    held.assign(data, data + size);
+    heldGeneration = generation;
+    return;
+  }
+  if (generation == heldGeneration + period &&
+      std::equal(held.begin(), held.end(), data)) {
+    checking = false;
+  } else {
+    ++collisions;
+    checking = false;
+    period = firstRepeat = 0;
+  }
+  held.clear();
+  held.shrink_to_fit();
+}
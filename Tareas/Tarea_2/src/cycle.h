@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef unsigned char ubyte;
+
+// World hashes are the XOR of a fixed 64-bit key per alive cell, so the hash
+// of the next generation is the current one with the keys of the changed
+// cells toggled. The update kernels see every change anyway and fold the
+// keys in as they write, without another pass over the world. cellKey must
+// stay in sync with the copy in kernel.cl.
+inline uint64_t cellKey(uint64_t cell) {
+  uint64_t z = cell + 0x9e3779b97f4a7c15ull; // SplitMix64 finalizer
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Keys of the set bits of a packed word, bit i being cell firstCell + i
+inline uint64_t changedBitsKey(uint64_t changed, uint64_t firstCell) {
+  uint64_t key = 0;
+  for (; changed; changed &= changed - 1)
+    key ^= cellKey(firstCell + __builtin_ctzll(changed));
+  return key;
+}
+
+// Full hash of a flat world, for the first generation of a run
+uint64_t worldHash(const ubyte *data, size_t size);
+
+struct CycleOptions {
+  size_t maxPeriod = 0; // Longest period looked for, 0 disables detection
+  bool verify = false;  // Confirm hash matches on the cells themselves
+};
+
+// Follows the hash of every generation of a run and stops it once the world
+// repeats one of the last maxPeriod generations. Without verification a
+// hash match is taken as the cycle. With it, the world is handed over once
+// on the match and again one period later, and only a true repeat stops the
+// run.
+class CycleWatch {
+public:
+  explicit CycleWatch(const CycleOptions &options)
+      : options(options), recent(options.maxPeriod) {}
+
+  bool enabled() const { return options.maxPeriod > 0; }
+
+  // Records the hash of `generation`, called for consecutive generations
+  void observe(uint64_t generation, uint64_t hash);
+
+  // Generation whose world verification needs next, 0 when none
+  uint64_t wantsWorld() const;
+  void offer(uint64_t generation, const ubyte *data, size_t size);
+
+  bool found() const { return period > 0 && !checking; }
+
+  uint64_t firstRepeat = 0; // First generation equal to an earlier one
+  uint64_t period = 0;
+  size_t collisions = 0;    // Hash matches the cells did not confirm
+
+private:
+  CycleOptions options;
+  std::vector<uint64_t> recent; // Hash of generation g at g % maxPeriod
+  size_t stored = 0;
+  bool checking = false;        // Waiting to verify firstRepeat / period
+  uint64_t heldGeneration = 0;
+  std::vector<ubyte> held;
+};
@@ -0,0 +1,107 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+// Function local so registrations from other static initializers are safe
+static std::map<std::string, EngineFactory> &registry() {
+  static std::map<std::string, EngineFactory> factories;
+  return factories;
+}
+
+bool registerEngine(const std::string &key, EngineFactory factory) {
+  return registry().emplace(key, factory).second;
+}
+
+std::unique_ptr<LifeEngine> createEngine(const std::string &key,
+                                         const EngineOptions &options) {
+  auto it = registry().find(key);
+  if (it == registry().end())
+    throw std::runtime_error("[Engine] Unknown engine " + key + '.');
+  return it->second(options);
+}
+
+std::vector<std::string> engineNames() {
+  std::vector<std::string> names;
+  for (const auto &entry : registry())
+    names.push_back(entry.first);
+  return names;
+}
+
+static bool matchesReference(LifeEngine &engine, LifeEngine &reference,
+                             size_t width, size_t height, size_t generations,
+                             const RandomOptions &world) {
+  std::vector<ubyte> initial(width * height), expected(width * height),
+      result(width * height);
+  fillRandomWorld(initial.data(), initial.size(), world);
+
+  reference.load(initial.data(), width, height);
+  reference.step(generations);
+  reference.readback(expected.data());
+
+  engine.load(initial.data(), width, height);
+  engine.step(generations);
+  engine.readback(result.data());
+  return expected == result;
+}
+
+void benchmarkEngines(const std::vector<std::string> &keys,
+                      const std::vector<unsigned> &threadOptions,
+                      const EngineOptions &options, const BenchOptions &bench,
+                      BenchReport &report, const std::string &reference) {
+  RandomOptions world = bench.world;
+
+  for (const auto &size : bench.sizes) {
+    size_t width = size.first, height = size.second;
+    std::cout << width << 'x' << height << " (" << width * height << ")\n";
+    std::vector<ubyte> cells(width * height);
+
+    for (const std::string &key : keys) {
+      std::set<unsigned> measured;
+      for (unsigned threads : threadOptions) {
+        EngineOptions engineOptions = options;
+        engineOptions.threads = threads;
+
+        // Sizes or settings an engine cannot handle (Hashlife needs powers
+        // of two, Bitpacked whole words, OpenCL devices limit work-groups)
+        // are skipped instead of ending the run
+        try {
+          std::unique_ptr<LifeEngine> engine =
+              createEngine(key, engineOptions);
+          if (!measured.insert(engine->threads()).second)
+            continue;
+          if (engine->device() != "host")
+            report.meta("device " + key, engine->device());
+
+          if (!reference.empty() && key != reference) {
+            // Reference engines may share state with the one under test, so
+            // the check finishes before the engine is loaded for timing
+            std::unique_ptr<LifeEngine> expected =
+                createEngine(reference, options);
+            if (!matchesReference(*engine, *expected, width, height,
+                                  bench.iterations, world))
+              std::cerr << engine->name() << " does not match "
+                        << expected->name() << '\n';
+          }
+
+          auto prepare = [&]() {
+            fillRandomWorld(cells.data(), cells.size(), world);
+            ++world.seed;
+            engine->load(cells.data(), width, height);
+          };
+          auto run = [&]() { engine->step(bench.iterations); };
+          auto kernelTimes = [&]() { return engine->kernelTimes(); };
+          report.add(engine->name(), width, height, engine->threads(),
+                     bench.iterations,
+                     measure(bench, bench.iterations, prepare, run,
+                             kernelTimes));
+        } catch (const std::logic_error &e) {
+          std::cerr << e.what() << '\n';
+        }
+      }
+    }
+  }
+}
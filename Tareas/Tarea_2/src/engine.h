@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "random.h"
+#include "rule.h"
+
+typedef unsigned char ubyte;
+
+// Backend independent Life engine. load() uploads a flat row-major world,
+// step() advances it and returns once the generations are done, readback()
+// downloads the current world. Only step() is meant to be timed; engines
+// with device timers also report the kernels of the last step().
+class LifeEngine {
+public:
+  virtual ~LifeEngine() = default;
+
+  virtual std::string name() const = 0; // Mode column of the report
+  virtual void load(const ubyte *data, size_t width, size_t height) = 0;
+  virtual void step(size_t generations) = 0;
+  virtual void readback(ubyte *data) = 0;
+
+  // step() that also stores in changes[g] the XOR of the cellKey (cycle.h)
+  // of every cell generation g changed, for engines that fold it into their
+  // update. The others return false without stepping.
+  virtual bool stepHashed(size_t, uint64_t *) { return false; }
+
+  virtual unsigned threads() const { return 1; }
+  virtual std::string device() const { return "host"; }
+  virtual KernelTimes kernelTimes() const { return KernelTimes(); }
+};
+
+struct EngineOptions {
+  Rule rule = conwayRule;
+  unsigned threads = 0; // Threads per block or workers, 0 picks a default
+  std::string device;   // OpenCL device type, "gpu", "cpu" or "" for either
+  unsigned steps = 0;   // Generations per pass of temporally blocked engines
+};
+
+typedef std::unique_ptr<LifeEngine> (*EngineFactory)(const EngineOptions &);
+
+// Backends register their engines from static initializers in their own
+// translation units, so every binary offers exactly the backends it links.
+bool registerEngine(const std::string &key, EngineFactory factory);
+std::unique_ptr<LifeEngine> createEngine(const std::string &key,
+                                         const EngineOptions &options);
+std::vector<std::string> engineNames();
+
+// Times every engine over every size and thread option, skipping thread
+// options an engine ignores, on worlds drawn from bench.world. Engines are
+// first checked against `reference` unless it is empty or the engine itself.
+void benchmarkEngines(const std::vector<std::string> &keys,
+                      const std::vector<unsigned> &threadOptions,
+                      const EngineOptions &options, const BenchOptions &bench,
+                      BenchReport &report, const std::string &reference);
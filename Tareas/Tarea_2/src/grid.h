@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+typedef unsigned char ubyte;
+
+// One row of a Grid. Indices -1 and size are the ghost cells, which live in
+// the same allocation as the row.
+struct RowSpan {
+  ubyte *cells;
+  size_t size;
+
+  ubyte &operator[](ptrdiff_t x) const { return cells[x]; }
+  ubyte *begin() const { return cells; }
+  ubyte *end() const { return cells + size; }
+};
+
+// A width x height world in a single 64 byte aligned allocation. Rows are
+// `pitch` bytes apart and the first cell of each is aligned; the padding
+// holds the ghost column on either side, and a ghost row sits above and
+// below, so stencils read their neighbours without wrapping indices. The
+// padding also leaves room to read and write whole vectors past the last
+// cell.
+class Grid {
+public:
+  static constexpr size_t alignment = 64;
+
+  Grid() = default;
+
+  Grid(size_t width, size_t height)
+      : width(width), height(height),
+        pitch((width + 2 + alignment - 1) / alignment * alignment) {
+    size_t bytes = alignment + (height + 2) * pitch + alignment;
+    storage = static_cast<ubyte *>(std::aligned_alloc(alignment, bytes));
+    if (!storage)
+      throw std::bad_alloc();
+    std::memset(storage, 0, bytes);
+  }
+
+  Grid(Grid &&other) noexcept { swap(other); }
+
+  Grid &operator=(Grid &&other) noexcept {
+    Grid(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  Grid(const Grid &) = delete;
+  Grid &operator=(const Grid &) = delete;
+
+  ~Grid() { std::free(storage); }
+
+  // Rows -1 and height are the ghost rows
+  RowSpan row(ptrdiff_t y) const {
+    return {storage + alignment + (y + 1) * pitch, width};
+  }
+
+  void load(const ubyte *cells) {
+    for (size_t y = 0; y < height; ++y)
+      std::memcpy(row(y).cells, cells + y * width, width);
+  }
+
+  void store(ubyte *cells) const {
+    for (size_t y = 0; y < height; ++y)
+      std::memcpy(cells + y * width, row(y).cells, width);
+  }
+
+  // Copies the opposite ends of row y into its ghost columns
+  void wrapRow(ptrdiff_t y) {
+    RowSpan cells = row(y);
+    cells[-1] = cells[width - 1];
+    cells[width] = cells[0];
+  }
+
+  // Copies the opposite edges into the ghost cells, so the world wraps
+  // around like the flat engines.
+  void wrapHalo() {
+    for (size_t y = 0; y < height; ++y)
+      wrapRow(y);
+    std::memcpy(row(-1).cells - 1, row(height - 1).cells - 1, width + 2);
+    std::memcpy(row(height).cells - 1, row(0).cells - 1, width + 2);
+  }
+
+  void swap(Grid &other) noexcept {
+    std::swap(storage, other.storage);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(pitch, other.pitch);
+  }
+
+  explicit operator bool() const { return storage != nullptr; }
+
+  size_t width = 0;
+  size_t height = 0;
+  size_t pitch = 0;
+
+private:
+  ubyte *storage = nullptr;
+};
@@ -0,0 +1,315 @@
+#include "hashlife.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static inline size_t hashChildren(uint32_t nw, uint32_t ne, uint32_t sw,
+                                  uint32_t se) {
+  uint64_t h = ((((uint64_t)nw << 32) | ne) * 0x9E3779B97F4A7C15ull) ^
+               ((((uint64_t)sw << 32) | se) * 0xC2B2AE3D27D4EB4Full);
+  return h ^ (h >> 32);
+}
+
+static inline unsigned log2Of(size_t value) {
+  unsigned level = 0;
+  while ((size_t(1) << level) < value)
+    ++level;
+  return level;
+}
+
+Hashlife::Hashlife() {
+  // Level 0 nodes are the dead and alive cells
+  nodes.push_back({none, none, none, none, none, none, 0, 0});
+  nodes.push_back({none, none, none, none, none, none, 0, 1});
+  rehash(1 << 16);
+}
+
+// Loading
+void Hashlife::load(const ubyte *data, size_t width, size_t height) {
+  if (width == 0 || height == 0 || (width & (width - 1)) ||
+      (height & (height - 1)))
+    throw std::logic_error("[Hashlife] World sides must be powers of two.");
+
+  nodes.resize(2);
+  rehash(1 << 16);
+  this->width = width;
+  this->height = height;
+  generations = 0;
+
+  // A torus is also periodic with any multiple of its sides, so the world is
+  // repeated up to a square of at least 4x4 cells. Hash consing keeps the
+  // copies free.
+  rootLevel = log2Of(std::max({width, height, (size_t)4}));
+  unsigned blockLevel = log2Of(std::min(width, height));
+
+  std::vector<uint32_t> blocks;
+  for (size_t y = 0; y < height; y += size_t(1) << blockLevel)
+    for (size_t x = 0; x < width; x += size_t(1) << blockLevel)
+      blocks.push_back(build(data, x, y, blockLevel));
+  root = tile(blocks, 0, 0, rootLevel, blockLevel);
+}
+
+uint32_t Hashlife::build(const ubyte *data, size_t x, size_t y,
+                         unsigned level) {
+  if (level == 0)
+    return data[y * width + x] ? 1 : 0;
+
+  size_t half = size_t(1) << (level - 1);
+  return join(build(data, x, y, level - 1), build(data, x + half, y, level - 1),
+              build(data, x, y + half, level - 1),
+              build(data, x + half, y + half, level - 1));
+}
+
+uint32_t Hashlife::tile(const std::vector<uint32_t> &blocks, size_t x,
+                        size_t y, unsigned level, unsigned blockLevel) {
+  if (level == blockLevel)
+    return blocks[((y % height) >> blockLevel) * (width >> blockLevel) +
+                  ((x % width) >> blockLevel)];
+
+  size_t half = size_t(1) << (level - 1);
+  return join(tile(blocks, x, y, level - 1, blockLevel),
+              tile(blocks, x + half, y, level - 1, blockLevel),
+              tile(blocks, x, y + half, level - 1, blockLevel),
+              tile(blocks, x + half, y + half, level - 1, blockLevel));
+}
+
+void Hashlife::store(ubyte *data) const {
+  std::memset(data, 0, width * height);
+  write(data, root, 0, 0);
+}
+
+void Hashlife::write(ubyte *data, uint32_t id, size_t x, size_t y) const {
+  const Node &node = nodes[id];
+  if (node.population == 0 || x >= width || y >= height)
+    return;
+  if (node.level == 0) {
+    data[y * width + x] = 1;
+    return;
+  }
+
+  size_t half = size_t(1) << (node.level - 1);
+  write(data, node.nw, x, y);
+  write(data, node.ne, x + half, y);
+  write(data, node.sw, x, y + half);
+  write(data, node.se, x + half, y + half);
+}
+
+// Stepping
+void Hashlife::setRule(const Rule &rule) {
+  this->rule = rule;
+  for (Node &node : nodes)
+    node.result = none;
+  slowResults.clear();
+}
+
+void Hashlife::step(unsigned log2Generations) {
+  // The root advances at most 2^(rootLevel - 1) generations at once
+  unsigned maxStep = rootLevel - 1;
+  if (log2Generations <= maxStep) {
+    advance(log2Generations);
+    return;
+  }
+  for (uint64_t i = 0; i < (uint64_t(1) << (log2Generations - maxStep)); ++i)
+    advance(maxStep);
+}
+
+uint64_t Hashlife::generation() const { return generations; }
+
+void Hashlife::advance(unsigned log2Generations) {
+  // RESULT of four copies of the torus is the torus advanced and shifted by
+  // half its side, swapping the quadrants diagonally undoes the shift.
+  uint32_t result = this->result(join(root, root, root, root), log2Generations);
+  Node centre = nodes[result];
+  root = join(centre.se, centre.sw, centre.ne, centre.nw);
+  generations += uint64_t(1) << log2Generations;
+
+  if (memoryUsage() > memoryLimit)
+    collectGarbage();
+}
+
+uint32_t Hashlife::centre(uint32_t id) {
+  Node node = nodes[id];
+  return join(nodes[node.nw].se, nodes[node.ne].sw, nodes[node.sw].ne,
+              nodes[node.se].nw);
+}
+
+uint32_t Hashlife::result(uint32_t id, unsigned log2Generations) {
+  Node node = nodes[id];
+  // Steps of 2^(level - 2) or more all take the node at full speed
+  bool full = log2Generations >= node.level - 2;
+  uint64_t key = uint64_t(id) << 8 | log2Generations;
+  if (full && node.result != none)
+    return node.result;
+  if (!full) {
+    auto found = slowResults.find(key);
+    if (found != slowResults.end())
+      return found->second;
+  }
+
+  uint32_t result;
+  if (node.level == 2) {
+    result = leafResult(id);
+  } else {
+    Node nw = nodes[node.nw], ne = nodes[node.ne];
+    Node sw = nodes[node.sw], se = nodes[node.se];
+
+    // Nine overlapping subnodes of half the size
+    uint32_t n00 = node.nw;
+    uint32_t n01 = join(nw.ne, ne.nw, nw.se, ne.sw);
+    uint32_t n02 = node.ne;
+    uint32_t n10 = join(nw.sw, nw.se, sw.nw, sw.ne);
+    uint32_t n11 = join(nw.se, ne.sw, sw.ne, se.nw);
+    uint32_t n12 = join(ne.sw, ne.se, se.nw, se.ne);
+    uint32_t n20 = node.sw;
+    uint32_t n21 = join(sw.ne, se.nw, sw.se, se.sw);
+    uint32_t n22 = node.se;
+
+    // At full speed both halves of the step advance, otherwise the first
+    // half just takes the centres and the second one does all the work.
+    auto first = [&](uint32_t sub) {
+      return full ? this->result(sub, log2Generations) : centre(sub);
+    };
+    uint32_t r00 = first(n00), r01 = first(n01), r02 = first(n02);
+    uint32_t r10 = first(n10), r11 = first(n11), r12 = first(n12);
+    uint32_t r20 = first(n20), r21 = first(n21), r22 = first(n22);
+
+    uint32_t rnw = this->result(join(r00, r01, r10, r11), log2Generations);
+    uint32_t rne = this->result(join(r01, r02, r11, r12), log2Generations);
+    uint32_t rsw = this->result(join(r10, r11, r20, r21), log2Generations);
+    uint32_t rse = this->result(join(r11, r12, r21, r22), log2Generations);
+    result = join(rnw, rne, rsw, rse);
+  }
+
+  if (full)
+    nodes[id].result = result;
+  else
+    slowResults[key] = result;
+  return result;
+}
+
+// One generation of the centre 2x2 cells of a 4x4 node
+uint32_t Hashlife::leafResult(uint32_t id) {
+  Node node = nodes[id];
+  uint32_t quadrants[4] = {node.nw, node.ne, node.sw, node.se};
+
+  uint32_t cells = 0; // Bit y * 4 + x
+  for (int q = 0; q < 4; ++q) {
+    const Node &quadrant = nodes[quadrants[q]];
+    int shift = (q >> 1) * 8 + (q & 1) * 2;
+    cells |= (quadrant.nw | quadrant.ne << 1 | quadrant.sw << 4 |
+              quadrant.se << 5)
+             << shift;
+  }
+
+  auto next = [this, cells](int x, int y) -> uint32_t {
+    uint32_t alive = 0;
+    for (int dy = -1; dy <= 1; ++dy)
+      for (int dx = -1; dx <= 1; ++dx)
+        if (dx || dy)
+          alive += (cells >> ((y + dy) * 4 + x + dx)) & 1;
+    return nextState(rule, alive, (cells >> (y * 4 + x)) & 1);
+  };
+  return join(next(1, 1), next(2, 1), next(1, 2), next(2, 2));
+}
+
+// Node store
+uint32_t Hashlife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+  size_t bucket = hashChildren(nw, ne, sw, se) & (buckets.size() - 1);
+  for (uint32_t id = buckets[bucket]; id != none; id = nodes[id].next) {
+    const Node &node = nodes[id];
+    if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+      return id;
+  }
+
+  if (nodes.size() >= none)
+    throw std::length_error("[Hashlife] Node store is full.");
+
+  uint32_t id = nodes.size();
+  uint64_t population = nodes[nw].population + nodes[ne].population +
+                        nodes[sw].population + nodes[se].population;
+  nodes.push_back(
+      {nw, ne, sw, se, none, buckets[bucket], nodes[nw].level + 1, population});
+  buckets[bucket] = id;
+
+  if (nodes.size() > buckets.size() / 4 * 3)
+    rehash(buckets.size() * 2);
+  return id;
+}
+
+void Hashlife::rehash(size_t size) {
+  buckets.assign(size, none);
+  for (uint32_t id = 2; id < nodes.size(); ++id) {
+    Node &node = nodes[id];
+    size_t bucket =
+        hashChildren(node.nw, node.ne, node.sw, node.se) & (size - 1);
+    node.next = buckets[bucket];
+    buckets[bucket] = id;
+  }
+}
+
+void Hashlife::setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+
+// Keeps the nodes reachable from the root. Children are always created before
+// their parents, so compacting in place in creation order is safe.
+void Hashlife::collectGarbage() {
+  const uint32_t marked = 0;
+  std::vector<uint32_t> remap(nodes.size(), none);
+  remap[0] = remap[1] = marked;
+
+  std::vector<uint32_t> stack{root};
+  while (!stack.empty()) {
+    uint32_t id = stack.back();
+    stack.pop_back();
+    if (remap[id] != none)
+      continue;
+    remap[id] = marked;
+    const Node &node = nodes[id];
+    stack.insert(stack.end(), {node.nw, node.ne, node.sw, node.se});
+  }
+
+  uint32_t count = 0;
+  for (uint32_t id = 0; id < nodes.size(); ++id)
+    if (remap[id] != none)
+      remap[id] = count++;
+
+  for (uint32_t id = 0; id < nodes.size(); ++id) {
+    if (remap[id] == none)
+      continue;
+    Node node = nodes[id];
+    if (node.level > 0) {
+      node.nw = remap[node.nw];
+      node.ne = remap[node.ne];
+      node.sw = remap[node.sw];
+      node.se = remap[node.se];
+    }
+    if (node.result != none)
+      node.result = remap[node.result];
+    nodes[remap[id]] = node;
+  }
+
+  nodes.resize(count);
+  root = remap[root];
+
+  std::unordered_map<uint64_t, uint32_t> kept;
+  for (const auto &[key, result] : slowResults) {
+    uint32_t id = key >> 8;
+    if (remap[id] != none && remap[result] != none)
+      kept.emplace(uint64_t(remap[id]) << 8 | (key & 0xFF), remap[result]);
+  }
+  slowResults.swap(kept);
+
+  size_t size = 1 << 16;
+  while (size / 4 * 3 < nodes.size() * 2)
+    size *= 2;
+  rehash(size);
+}
+
+size_t Hashlife::nodeCount() const { return nodes.size(); }
+
+size_t Hashlife::memoryUsage() const {
+  // A hash map entry costs its key, value and about two pointers
+  return nodes.size() * sizeof(Node) + buckets.size() * sizeof(uint32_t) +
+         slowResults.size() * (sizeof(uint64_t) + 2 * sizeof(void *) + 8) +
+         slowResults.bucket_count() * sizeof(void *);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "rule.h"
+
+typedef unsigned char ubyte;
+
+// Hashlife over a toroidal world whose sides are powers of two. The world is
+// kept as a hash-consed quadtree where every node memoizes its RESULT, the
+// centre half of the node advanced 2^(level - 2) generations. Smaller steps
+// are memoized apart, keyed by node and step, so runs that mix step sizes
+// keep everything computed so far.
+class Hashlife {
+public:
+  Hashlife();
+
+  // Converts from and to the flat row-major layout used by serial.cpp
+  void load(const ubyte *data, size_t width, size_t height);
+  void store(ubyte *data) const;
+
+  void setRule(const Rule &rule); // Drops every memoized RESULT
+  void step(unsigned log2Generations); // Advance 2^log2Generations
+  uint64_t generation() const;
+
+  // Garbage is collected between steps once the node store exceeds the cap
+  void setMemoryLimit(size_t bytes);
+  void collectGarbage();
+  size_t nodeCount() const;
+  size_t memoryUsage() const;
+
+private:
+  static constexpr uint32_t none = UINT32_MAX;
+
+  struct Node {
+    uint32_t nw, ne, sw, se;
+    uint32_t result; // Memoized full speed RESULT, or none
+    uint32_t next;   // Next node in the same hash bucket
+    uint32_t level;
+    uint64_t population;
+  };
+
+  uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+  uint32_t centre(uint32_t id);
+  uint32_t result(uint32_t id, unsigned log2Generations);
+  uint32_t leafResult(uint32_t id);
+  void advance(unsigned log2Generations);
+  void rehash(size_t buckets);
+  uint32_t build(const ubyte *data, size_t x, size_t y, unsigned level);
+  uint32_t tile(const std::vector<uint32_t> &blocks, size_t x, size_t y,
+                unsigned level, unsigned blockLevel);
+  void write(ubyte *data, uint32_t id, size_t x, size_t y) const;
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> buckets;
+  uint32_t root = 0;
+  unsigned rootLevel = 0;
+  // RESULTs of steps below full speed, by (node << 8 | log2Generations)
+  std::unordered_map<uint64_t, uint32_t> slowResults;
+  size_t width = 0;
+  size_t height = 0;
+  uint64_t generations = 0;
+  size_t memoryLimit = SIZE_MAX;
+  Rule rule = conwayRule;
+};
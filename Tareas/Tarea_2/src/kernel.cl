@@ -1,15 +1,16 @@
 typedef unsigned char ubyte;
 
-kernel void fillRandomLifeData(global ubyte *lifeData, ulong size, uint seed) {
-  size_t gid = get_global_id(0);
-  size_t totalThreads = get_global_size(0);
-
-  for (ulong i = gid; i < size; i += totalThreads) {
-    uint x = i ^ seed;
-    x = (x * 1664525u + 1013904223u);
-    lifeData[i] = (x >> 24) & 1;
-  }
-}
+// Rule masks come from the build options, bit n is set when n alive
+// neighbours give birth or survival. Defaults to B3/S23.
+#ifndef BIRTH_MASK
+#define BIRTH_MASK 0x008u
+#endif
+#ifndef SURVIVAL_MASK
+#define SURVIVAL_MASK 0x00Cu
+#endif
+
+#define NEXT_STATE(alive, self)                                                \
+  ((((self) ? SURVIVAL_MASK : BIRTH_MASK) >> (alive)) & 1u)
 
 kernel void simpleLifeKernel(global volatile const ubyte *lifeData,
                              ulong worldWidth, ulong worldHeight,
@@ -19,22 +20,81 @@ kernel void simpleLifeKernel(global volatile const ubyte *lifeData,
   if (index >= worldSize)
     return;
 
-  uint x = index % worldWidth;
-  uint yAbs = index / worldWidth;
+  size_t x = index % worldWidth;
+  size_t yAbs = index - x;
 
-  uint xLeft = (x + worldWidth - 1) % worldWidth;
-  uint xRight = (x + 1) % worldWidth;
+  size_t xLeft = (x + worldWidth - 1) % worldWidth;
+  size_t xRight = (x + 1) % worldWidth;
 
-  uint yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
-  uint yAbsDown = (yAbs + worldWidth) % worldSize;
+  size_t yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
+  size_t yAbsDown = (yAbs + worldWidth) % worldSize;
 
   uint aliveCells = lifeData[xLeft + yAbsUp] + lifeData[x + yAbsUp] +
                     lifeData[xRight + yAbsUp] + lifeData[xLeft + yAbs] +
                     lifeData[xRight + yAbs] + lifeData[xLeft + yAbsDown] +
                     lifeData[x + yAbsDown] + lifeData[xRight + yAbsDown];
 
-  resultLifeData[x + yAbs] =
-      (aliveCells == 3 || (aliveCells == 2 && lifeData[x + yAbs])) ? 1 : 0;
+  resultLifeData[x + yAbs] = NEXT_STATE(aliveCells, lifeData[x + yAbs]);
+}
+
+// Same keys as cellKey in cycle.h
+ulong cellKey(ulong cell) {
+  ulong z = cell + 0x9e3779b97f4a7c15ul;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ul;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebul;
+  return z ^ (z >> 31);
+}
+
+// simpleLifeKernel that also folds the cellKey of every changed cell into
+// the world hash delta of this generation. The keys are XOR-reduced in the
+// work-group and work-item 0 adds the group's share with two 32-bit atomics,
+// changes[2 generation] holding the low half. Work-items past the world
+// stay for the barriers.
+kernel void hashedLifeKernel(global volatile const ubyte *lifeData,
+                             ulong worldWidth, ulong worldHeight,
+                             global ubyte *resultLifeData, ulong worldSize,
+                             global uint *changes, uint generation,
+                             local ulong *scratch) {
+  size_t index = get_global_id(0);
+  size_t lid = get_local_id(0);
+  ulong key = 0;
+
+  if (index < worldSize) {
+    size_t x = index % worldWidth;
+    size_t yAbs = index - x;
+
+    size_t xLeft = (x + worldWidth - 1) % worldWidth;
+    size_t xRight = (x + 1) % worldWidth;
+
+    size_t yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
+    size_t yAbsDown = (yAbs + worldWidth) % worldSize;
+
+    uint aliveCells = lifeData[xLeft + yAbsUp] + lifeData[x + yAbsUp] +
+                      lifeData[xRight + yAbsUp] + lifeData[xLeft + yAbs] +
+                      lifeData[xRight + yAbs] + lifeData[xLeft + yAbsDown] +
+                      lifeData[x + yAbsDown] + lifeData[xRight + yAbsDown];
+
+    ubyte self = lifeData[x + yAbs];
+    ubyte next = NEXT_STATE(aliveCells, self);
+    resultLifeData[x + yAbs] = next;
+    if (next != self)
+      key = cellKey(index);
+  }
+
+  scratch[lid] = key;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  // Halving that also works for group sizes that are not powers of two
+  for (size_t n = get_local_size(0); n > 1; n = (n + 1) / 2) {
+    size_t half = (n + 1) / 2;
+    if (lid + half < n)
+      scratch[lid] ^= scratch[lid + half];
+    barrier(CLK_LOCAL_MEM_FENCE);
+  }
+
+  if (lid == 0 && scratch[0]) {
+    atomic_xor(&changes[2 * generation], (uint)scratch[0]);
+    atomic_xor(&changes[2 * generation + 1], (uint)(scratch[0] >> 32));
+  }
 }
 
 kernel void simpleLifeKernelIfs(global volatile const ubyte *lifeData,
@@ -45,14 +105,14 @@ kernel void simpleLifeKernelIfs(global volatile const ubyte *lifeData,
   if (index >= worldSize)
     return;
 
-  uint x = index % worldWidth;
-  uint yAbs = index / worldWidth;
+  size_t x = index % worldWidth;
+  size_t yAbs = index - x;
 
-  uint xLeft = (x + worldWidth - 1) % worldWidth;
-  uint xRight = (x + 1) % worldWidth;
+  size_t xLeft = (x + worldWidth - 1) % worldWidth;
+  size_t xRight = (x + 1) % worldWidth;
 
-  uint yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
-  uint yAbsDown = (yAbs + worldWidth) % worldSize;
+  size_t yAbsUp = (yAbs + worldSize - worldWidth) % worldSize;
+  size_t yAbsDown = (yAbs + worldWidth) % worldSize;
 
   uint aliveCells = 0;
   if (lifeData[xLeft + yAbsUp])
@@ -72,7 +132,7 @@ kernel void simpleLifeKernelIfs(global volatile const ubyte *lifeData,
   if (lifeData[xRight + yAbsDown])
     aliveCells++;
 
-  if (aliveCells == 3 || (aliveCells == 2 && lifeData[x + yAbs]))
+  if (NEXT_STATE(aliveCells, lifeData[x + yAbs]))
     resultLifeData[x + yAbs] = 1;
   else
     resultLifeData[x + yAbs] = 0;
@@ -87,10 +147,10 @@ kernel void simpleLifeKernel2D(global volatile const ubyte *lifeData,
   if (x >= worldWidth || y >= worldHeight)
     return;
 
-  uint xLeft = (x + worldWidth - 1) % worldWidth;
-  uint xRight = (x + 1) % worldWidth;
-  uint yUp = (y + worldHeight - 1) % worldHeight;
-  uint yDown = (y + 1) % worldHeight;
+  size_t xLeft = (x + worldWidth - 1) % worldWidth;
+  size_t xRight = (x + 1) % worldWidth;
+  size_t yUp = (y + worldHeight - 1) % worldHeight;
+  size_t yDown = (y + 1) % worldHeight;
 
 // 2D indexing
 #define IDX(xx, yy) ((size_t)(yy) * (size_t)(worldWidth) + (size_t)(xx))
@@ -100,6 +160,59 @@ kernel void simpleLifeKernel2D(global volatile const ubyte *lifeData,
                     lifeData[IDX(xRight, y)] + lifeData[IDX(xLeft, yDown)] +
                     lifeData[IDX(x, yDown)] + lifeData[IDX(xRight, yDown)];
 
-  resultLifeData[IDX(x, y)] =
-      (aliveCells == 3 || (aliveCells == 2 && lifeData[IDX(x, y)])) ? 1 : 0;
+  resultLifeData[IDX(x, y)] = NEXT_STATE(aliveCells, lifeData[IDX(x, y)]);
+}
+
+// Advances a tileWidth x tileHeight block `generations` steps per launch.
+// The block and a ghost border `generations` cells wide are read from global
+// memory once into local memory; generation g is only valid g cells in from
+// the border, so every step computes a smaller region and only the block
+// itself is written back. Both local buffers hold
+// (tileWidth + 2 generations) x (tileHeight + 2 generations) cells.
+kernel void tiledLifeKernel(global const ubyte *lifeData, ulong worldWidth,
+                            ulong worldHeight, global ubyte *resultLifeData,
+                            ulong worldSize, uint generations, uint tileWidth,
+                            uint tileHeight, local ubyte *tile,
+                            local ubyte *tileBuffer) {
+  size_t localX = get_local_id(0), localY = get_local_id(1);
+  size_t localWidth = get_local_size(0), localHeight = get_local_size(1);
+  size_t x0 = get_group_id(0) * tileWidth;
+  size_t y0 = get_group_id(1) * tileHeight;
+  uint pitch = tileWidth + 2 * generations;
+  uint rows = tileHeight + 2 * generations;
+
+  // Local cell (x, y) is world cell (x0 - generations + x, ...) on the torus
+  size_t left = x0 + worldWidth - generations % worldWidth;
+  size_t top = y0 + worldHeight - generations % worldHeight;
+  for (uint y = localY; y < rows; y += localHeight) {
+    size_t row = ((top + y) % worldHeight) * worldWidth;
+    for (uint x = localX; x < pitch; x += localWidth)
+      tile[y * pitch + x] = lifeData[row + (left + x) % worldWidth];
+  }
+
+  for (uint g = 1; g <= generations; ++g) {
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (uint y = g + localY; y < rows - g; y += localHeight) {
+      for (uint x = g + localX; x < pitch - g; x += localWidth) {
+        uint i = y * pitch + x;
+        uint aliveCells = tile[i - pitch - 1] + tile[i - pitch] +
+                          tile[i - pitch + 1] + tile[i - 1] + tile[i + 1] +
+                          tile[i + pitch - 1] + tile[i + pitch] +
+                          tile[i + pitch + 1];
+        tileBuffer[i] = NEXT_STATE(aliveCells, tile[i]);
+      }
+    }
+    local ubyte *swap = tile;
+    tile = tileBuffer;
+    tileBuffer = swap;
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  for (uint y = localY; y < tileHeight && y0 + y < worldHeight;
+       y += localHeight) {
+    for (uint x = localX; x < tileWidth && x0 + x < worldWidth;
+         x += localWidth)
+      resultLifeData[(y0 + y) * worldWidth + x0 + x] =
+          tile[(y + generations) * pitch + x + generations];
+  }
 }
@@ -0,0 +1,541 @@
+#define CL_TARGET_OPENCL_VERSION 120
+#include <CL/cl.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "engine.h"
+
+#define CHECK_CL_ERROR(err, msg)                                               \
+  if (err != CL_SUCCESS)                                                       \
+    throw std::runtime_error("[OpenCL] Error " + std::to_string(err) +       \
+                             " " + msg + '.');
+
+static size_t roundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// The 1D kernels run one work-item per cell in groups of threadsCount, the 2D
+// kernel in 16x16 groups. Global sizes are rounded up to whole groups and the
+// kernels skip work-items past the world.
+void runSimpleLifeKernel(cl_command_queue queue, cl_kernel kernel,
+                         cl_mem &d_lifeData, cl_mem &d_lifeDataBuffer,
+                         size_t worldWidth, size_t worldHeight,
+                         size_t worldSize, size_t iterationsCount,
+                         unsigned threadsCount, cl_uint dimensions,
+                         std::vector<cl_event> &events) {
+  size_t globalSize[2] = {roundUp(worldSize, threadsCount), 1};
+  size_t localSize[2] = {threadsCount, 1};
+  if (dimensions == 2) {
+    globalSize[0] = roundUp(worldWidth, 16);
+    globalSize[1] = roundUp(worldHeight, 16);
+    localSize[0] = localSize[1] = 16;
+  }
+
+  clSetKernelArg(kernel, 1, sizeof(cl_ulong), &worldWidth);
+  clSetKernelArg(kernel, 2, sizeof(cl_ulong), &worldHeight);
+  clSetKernelArg(kernel, 4, sizeof(cl_ulong), &worldSize);
+  for (size_t i = 0; i < iterationsCount; ++i) {
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &d_lifeData);
+    clSetKernelArg(kernel, 3, sizeof(cl_mem), &d_lifeDataBuffer);
+
+    cl_event event;
+    cl_int err = clEnqueueNDRangeKernel(queue, kernel, dimensions, nullptr,
+                                        globalSize, localSize, 0, nullptr,
+                                        &event);
+    CHECK_CL_ERROR(err, "enqueueing kernel");
+    events.push_back(event);
+    std::swap(d_lifeData, d_lifeDataBuffer);
+  }
+  cl_int err = clFinish(queue);
+  CHECK_CL_ERROR(err, "finish queue");
+}
+
+// Output block of one tiledLifeKernel work-group
+const cl_uint tileWidth = 128;
+const cl_uint tileHeight = 32;
+
+static size_t tileBytes(cl_uint generations) {
+  return size_t(tileWidth + 2 * generations) * (tileHeight + 2 * generations);
+}
+
+// Work-groups are up to 32 work-items wide, each covers one block and
+// advances it up to `steps` generations per launch.
+void runTiledLifeKernel(cl_command_queue queue, cl_kernel kernel,
+                        cl_mem &d_lifeData, cl_mem &d_lifeDataBuffer,
+                        size_t worldWidth, size_t worldHeight,
+                        size_t worldSize, size_t iterationsCount,
+                        const size_t localSize[2], cl_uint steps,
+                        std::vector<cl_event> &events) {
+  size_t globalSize[2] = {
+      (worldWidth + tileWidth - 1) / tileWidth * localSize[0],
+      (worldHeight + tileHeight - 1) / tileHeight * localSize[1]};
+
+  clSetKernelArg(kernel, 1, sizeof(cl_ulong), &worldWidth);
+  clSetKernelArg(kernel, 2, sizeof(cl_ulong), &worldHeight);
+  clSetKernelArg(kernel, 4, sizeof(cl_ulong), &worldSize);
+  clSetKernelArg(kernel, 6, sizeof(cl_uint), &tileWidth);
+  clSetKernelArg(kernel, 7, sizeof(cl_uint), &tileHeight);
+  for (size_t done = 0; done < iterationsCount;) {
+    cl_uint generations =
+        static_cast<cl_uint>(std::min<size_t>(steps, iterationsCount - done));
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &d_lifeData);
+    clSetKernelArg(kernel, 3, sizeof(cl_mem), &d_lifeDataBuffer);
+    clSetKernelArg(kernel, 5, sizeof(cl_uint), &generations);
+    clSetKernelArg(kernel, 8, tileBytes(generations), nullptr);
+    clSetKernelArg(kernel, 9, tileBytes(generations), nullptr);
+
+    cl_event event;
+    cl_int err = clEnqueueNDRangeKernel(queue, kernel, 2, nullptr, globalSize,
+                                        localSize, 0, nullptr, &event);
+    CHECK_CL_ERROR(err, "enqueueing tiled kernel");
+    events.push_back(event);
+    std::swap(d_lifeData, d_lifeDataBuffer);
+    done += generations;
+  }
+  cl_int err = clFinish(queue);
+  CHECK_CL_ERROR(err, "finish queue");
+}
+
+// Sums the profiling timestamps of finished launches and releases them
+static KernelTimes profile(std::vector<cl_event> &events) {
+  KernelTimes times;
+  for (cl_event event : events) {
+    cl_ulong queued = 0, submitted = 0, started = 0, ended = 0;
+    clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_QUEUED,
+                            sizeof(queued), &queued, nullptr);
+    clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,
+                            sizeof(submitted), &submitted, nullptr);
+    clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,
+                            sizeof(started), &started, nullptr);
+    cl_int err = clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,
+                                         sizeof(ended), &ended, nullptr);
+    clReleaseEvent(event);
+    if (err != CL_SUCCESS)
+      continue;
+    ++times.launches;
+    times.queued += (submitted - queued) * 1e-9;
+    times.submitted += (started - submitted) * 1e-9;
+    times.running += (ended - started) * 1e-9;
+  }
+  events.clear();
+  return times;
+}
+
+static std::string executableDirectory() {
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0)
+    return ".";
+  std::string executable(path, length);
+  return executable.substr(0, executable.rfind('/'));
+}
+
+// FNV-1a, stable across runs unlike std::hash
+static uint64_t fnv1a(const std::string &text,
+                      uint64_t hash = 0xcbf29ce484222325ull) {
+  for (unsigned char c : text)
+    hash = (hash ^ c) * 0x100000001b3ull;
+  return hash;
+}
+
+// Context, queue and program shared by every OpenCL engine. The first GPU
+// is preferred; without one the first CPU device is used, which lets PoCL
+// run the kernels on machines without a GPU.
+struct OpenClRuntime {
+  cl_device_id device = nullptr;
+  cl_context context = nullptr;
+  cl_command_queue queue = nullptr;
+  cl_program program = nullptr;
+  std::string deviceName;
+  std::string deviceType;
+  Rule rule = conwayRule;
+
+  OpenClRuntime(const std::string &type, const Rule &rule)
+      : deviceType(type), rule(rule) {
+    selectDevice();
+
+    cl_int err;
+    context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+    CHECK_CL_ERROR(err, "creating context");
+    queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE,
+                                 &err);
+    CHECK_CL_ERROR(err, "creating queue");
+    buildProgram();
+  }
+
+  OpenClRuntime(const OpenClRuntime &) = delete;
+  OpenClRuntime &operator=(const OpenClRuntime &) = delete;
+
+  ~OpenClRuntime() {
+    if (program)
+      clReleaseProgram(program);
+    if (queue)
+      clReleaseCommandQueue(queue);
+    if (context)
+      clReleaseContext(context);
+  }
+
+  void selectDevice() {
+    // CL_PLATFORM_NOT_FOUND_KHR (-1001) just means no runtime is installed
+    cl_uint numPlatforms = 0;
+    if (clGetPlatformIDs(0, nullptr, &numPlatforms) != CL_SUCCESS)
+      numPlatforms = 0;
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    if (numPlatforms > 0)
+      CHECK_CL_ERROR(clGetPlatformIDs(numPlatforms, platforms.data(), nullptr),
+                     "clGetPlatformIDs");
+
+    std::vector<cl_device_type> types;
+    if (deviceType != "cpu")
+      types.push_back(CL_DEVICE_TYPE_GPU);
+    if (deviceType != "gpu")
+      types.push_back(CL_DEVICE_TYPE_CPU);
+
+    for (cl_device_type type : types) {
+      for (const cl_platform_id platform : platforms) {
+        cl_uint numDevices = 0;
+        cl_int err = clGetDeviceIDs(platform, type, 1, &device, &numDevices);
+        if (err != CL_SUCCESS || numDevices == 0)
+          continue;
+
+        char name[256] = {};
+        clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(name) - 1, name,
+                        nullptr);
+        deviceName = name;
+        return;
+      }
+    }
+    throw std::runtime_error("[OpenCL] No " +
+                             (deviceType.empty() ? "GPU or CPU" : deviceType) +
+                             " device found.");
+  }
+
+  // kernel.cl is copied next to the binaries, so it is found wherever they
+  // are started from. Programs are compiled once per device, driver, build
+  // options and source and then loaded from kernel_cache next to kernel.cl.
+  void buildProgram() {
+    std::string directory = executableDirectory();
+    std::ifstream kernelFile(directory + "/kernel.cl");
+    if (!kernelFile) {
+      directory = ".";
+      kernelFile.open("kernel.cl");
+    }
+    if (!kernelFile)
+      throw std::runtime_error("[OpenCL] Cannot open kernel.cl next to the "
+                               "executable or in the working directory.");
+    std::string src(std::istreambuf_iterator<char>(kernelFile), {});
+
+    std::string buildOptions = "-D BIRTH_MASK=" + std::to_string(rule.birth) +
+                               "u -D SURVIVAL_MASK=" +
+                               std::to_string(rule.survival) + "u";
+    uint64_t key = fnv1a(src, fnv1a(buildOptions));
+    for (cl_device_info info : {CL_DEVICE_NAME, CL_DEVICE_VERSION,
+                                CL_DRIVER_VERSION}) {
+      char value[256] = {};
+      clGetDeviceInfo(device, info, sizeof(value) - 1, value, nullptr);
+      key = fnv1a(value, fnv1a("\n", key));
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    std::string cacheDirectory = directory + "/kernel_cache";
+    std::string cachePath = cacheDirectory + '/' + name;
+
+    if (loadBinary(cachePath, buildOptions))
+      return;
+
+    const char *srcStr = src.c_str();
+    size_t length = src.length();
+    cl_int err;
+    program = clCreateProgramWithSource(context, 1, &srcStr, &length, &err);
+    CHECK_CL_ERROR(err, "creating program");
+    err = clBuildProgram(program, 1, &device, buildOptions.c_str(), nullptr,
+                         nullptr);
+    if (err != CL_SUCCESS) {
+      size_t logSize;
+      clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, nullptr,
+                            &logSize);
+      std::vector<char> buildLog(logSize + 1);
+      clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, logSize,
+                            buildLog.data(), nullptr);
+      throw std::runtime_error(std::string("[OpenCL] Build error:\n") +
+                               buildLog.data());
+    }
+
+    mkdir(cacheDirectory.c_str(), 0755);
+    saveBinary(cachePath);
+  }
+
+  // A stale or foreign binary is not an error, the source is built instead
+  bool loadBinary(const std::string &path, const std::string &buildOptions) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+    std::vector<unsigned char> binary(std::istreambuf_iterator<char>(file),
+                                      {});
+    const unsigned char *binaryPtr = binary.data();
+    size_t length = binary.size();
+    cl_int status, err;
+    program = clCreateProgramWithBinary(context, 1, &device, &length,
+                                        &binaryPtr, &status, &err);
+    if (err == CL_SUCCESS && status == CL_SUCCESS &&
+        clBuildProgram(program, 1, &device, buildOptions.c_str(), nullptr,
+                       nullptr) == CL_SUCCESS)
+      return true;
+    if (program)
+      clReleaseProgram(program);
+    program = nullptr;
+    return false;
+  }
+
+  // Written to a temporary file first so concurrent runs never read half
+  // a binary; a read-only build directory just disables the cache
+  void saveBinary(const std::string &path) {
+    size_t length = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(length),
+                         &length, nullptr) != CL_SUCCESS ||
+        length == 0)
+      return;
+    std::vector<unsigned char> binary(length);
+    unsigned char *binaryPtr = binary.data();
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaryPtr),
+                         &binaryPtr, nullptr) != CL_SUCCESS)
+      return;
+
+    std::string temporary = path + '.' + std::to_string(getpid());
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(binary.data()), length);
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0)
+      std::remove(temporary.c_str());
+  }
+};
+
+// Rebuilt only when an engine asks for another device type or rule
+static std::shared_ptr<OpenClRuntime> openClRuntime(const EngineOptions &o) {
+  static std::shared_ptr<OpenClRuntime> runtime;
+  if (!runtime || runtime->deviceType != o.device || !(runtime->rule == o.rule))
+    runtime = std::make_shared<OpenClRuntime>(o.device, o.rule);
+  return runtime;
+}
+
+class OpenClEngine : public LifeEngine {
+public:
+  OpenClEngine(const char *title, const char *kernelName, cl_uint dimensions,
+               const EngineOptions &options)
+      : title(title), runtime(openClRuntime(options)),
+        kernelName(kernelName),
+        threadsCount(options.threads ? options.threads : 256),
+        dimensions(dimensions) {
+    cl_int err;
+    kernel = clCreateKernel(runtime->program, kernelName, &err);
+    CHECK_CL_ERROR(err, std::string("creating ") + kernelName);
+
+    err = clGetKernelWorkGroupInfo(kernel, runtime->device,
+                                   CL_KERNEL_WORK_GROUP_SIZE,
+                                   sizeof(maxGroupSize), &maxGroupSize,
+                                   nullptr);
+    CHECK_CL_ERROR(err, "reading work-group size");
+  }
+
+  ~OpenClEngine() override {
+    release();
+    clReleaseKernel(kernel);
+    if (hashedKernel)
+      clReleaseKernel(hashedKernel);
+  }
+
+  std::string name() const override { return title; }
+
+  void load(const ubyte *data, size_t width, size_t height) override {
+    if (width != worldWidth || height != worldHeight) {
+      release();
+      worldWidth = width;
+      worldHeight = height;
+
+      cl_int err;
+      d_lifeData = clCreateBuffer(runtime->context, CL_MEM_READ_WRITE,
+                                  size() * sizeof(ubyte), nullptr, &err);
+      CHECK_CL_ERROR(err, "creating buffer");
+      d_lifeDataBuffer = clCreateBuffer(runtime->context, CL_MEM_READ_WRITE,
+                                        size() * sizeof(ubyte), nullptr, &err);
+      CHECK_CL_ERROR(err, "creating buffer");
+    }
+    cl_int err =
+        clEnqueueWriteBuffer(runtime->queue, d_lifeData, CL_TRUE, 0,
+                             size() * sizeof(ubyte), data, 0, nullptr, nullptr);
+    CHECK_CL_ERROR(err, "writing world");
+  }
+
+  void step(size_t generations) override {
+    checkGroupSize(threads());
+    runSimpleLifeKernel(runtime->queue, kernel, d_lifeData, d_lifeDataBuffer,
+                        worldWidth, worldHeight, size(), generations,
+                        threadsCount, dimensions, events);
+    times = profile(events);
+  }
+
+  // Only the plain kernel has a hashed twin. The deltas are gathered in one
+  // buffer and read back once per call.
+  bool stepHashed(size_t generations, uint64_t *changes) override {
+    if (kernelName != "simpleLifeKernel")
+      return false;
+    checkGroupSize(threadsCount);
+    cl_int err;
+    if (!hashedKernel) {
+      hashedKernel =
+          clCreateKernel(runtime->program, "hashedLifeKernel", &err);
+      CHECK_CL_ERROR(err, "creating hashedLifeKernel");
+    }
+
+    std::vector<cl_uint> halves(2 * generations);
+    cl_mem d_changes = clCreateBuffer(
+        runtime->context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+        halves.size() * sizeof(cl_uint), halves.data(), &err);
+    CHECK_CL_ERROR(err, "creating hash buffer");
+
+    size_t globalSize = roundUp(size(), threadsCount);
+    size_t localSize = threadsCount;
+    cl_ulong width = worldWidth, height = worldHeight, cells = size();
+    clSetKernelArg(hashedKernel, 1, sizeof(cl_ulong), &width);
+    clSetKernelArg(hashedKernel, 2, sizeof(cl_ulong), &height);
+    clSetKernelArg(hashedKernel, 4, sizeof(cl_ulong), &cells);
+    clSetKernelArg(hashedKernel, 5, sizeof(cl_mem), &d_changes);
+    clSetKernelArg(hashedKernel, 7, threadsCount * sizeof(cl_ulong), nullptr);
+    for (cl_uint g = 0; g < generations; ++g) {
+      clSetKernelArg(hashedKernel, 0, sizeof(cl_mem), &d_lifeData);
+      clSetKernelArg(hashedKernel, 3, sizeof(cl_mem), &d_lifeDataBuffer);
+      clSetKernelArg(hashedKernel, 6, sizeof(cl_uint), &g);
+
+      cl_event event;
+      err = clEnqueueNDRangeKernel(runtime->queue, hashedKernel, 1, nullptr,
+                                   &globalSize, &localSize, 0, nullptr,
+                                   &event);
+      if (err != CL_SUCCESS)
+        clReleaseMemObject(d_changes);
+      CHECK_CL_ERROR(err, "enqueueing hashedLifeKernel");
+      events.push_back(event);
+      std::swap(d_lifeData, d_lifeDataBuffer);
+    }
+    err = clEnqueueReadBuffer(runtime->queue, d_changes, CL_TRUE, 0,
+                              halves.size() * sizeof(cl_uint), halves.data(),
+                              0, nullptr, nullptr);
+    clReleaseMemObject(d_changes);
+    CHECK_CL_ERROR(err, "reading hashes");
+    times = profile(events);
+
+    for (size_t g = 0; g < generations; ++g)
+      changes[g] = halves[2 * g] | uint64_t(halves[2 * g + 1]) << 32;
+    return true;
+  }
+
+  void readback(ubyte *data) override {
+    cl_int err =
+        clEnqueueReadBuffer(runtime->queue, d_lifeData, CL_TRUE, 0,
+                            size() * sizeof(ubyte), data, 0, nullptr, nullptr);
+    CHECK_CL_ERROR(err, "reading world");
+  }
+
+  // The 2D kernel always runs 16x16 groups
+  unsigned threads() const override {
+    return dimensions == 2 ? 256 : threadsCount;
+  }
+  std::string device() const override { return runtime->deviceName; }
+  KernelTimes kernelTimes() const override { return times; }
+
+protected:
+  size_t size() const { return worldWidth * worldHeight; }
+
+  void checkGroupSize(size_t groupSize) const {
+    if (groupSize > maxGroupSize)
+      throw std::logic_error("[OpenCL] " + title + " runs at most " +
+                             std::to_string(maxGroupSize) +
+                             " work-items per group.");
+  }
+
+  void release() {
+    if (d_lifeData)
+      clReleaseMemObject(d_lifeData);
+    if (d_lifeDataBuffer)
+      clReleaseMemObject(d_lifeDataBuffer);
+    d_lifeData = d_lifeDataBuffer = nullptr;
+  }
+
+  std::string title;
+  std::shared_ptr<OpenClRuntime> runtime;
+  std::string kernelName;
+  cl_kernel kernel = nullptr;
+  cl_kernel hashedKernel = nullptr; // Created by the first stepHashed
+  size_t maxGroupSize = 0;
+  std::vector<cl_event> events; // Launches of the running step
+  KernelTimes times;
+  cl_mem d_lifeData = nullptr;
+  cl_mem d_lifeDataBuffer = nullptr;
+  size_t worldWidth = 0;
+  size_t worldHeight = 0;
+  unsigned threadsCount;
+  cl_uint dimensions;
+};
+
+// Temporal blocking on the device, see tiledLifeKernel
+class OpenClTiledEngine : public OpenClEngine {
+public:
+  OpenClTiledEngine(const EngineOptions &options)
+      : OpenClEngine("OpenCL Tiled", "tiledLifeKernel", 2, options),
+        steps(options.steps ? options.steps : 4) {
+    localSize[0] = std::min<size_t>(threadsCount, 32);
+    localSize[1] = threadsCount / localSize[0];
+    title += " k=" + std::to_string(steps);
+
+    cl_ulong localMemory = 0;
+    clGetDeviceInfo(runtime->device, CL_DEVICE_LOCAL_MEM_SIZE,
+                    sizeof(localMemory), &localMemory, nullptr);
+    if (2 * tileBytes(steps) > localMemory)
+      throw std::logic_error("[OpenCL] k=" + std::to_string(steps) +
+                             " tiles do not fit in " +
+                             std::to_string(localMemory) +
+                             " bytes of local memory.");
+  }
+
+  void step(size_t generations) override {
+    checkGroupSize(threads());
+    runTiledLifeKernel(runtime->queue, kernel, d_lifeData, d_lifeDataBuffer,
+                       worldWidth, worldHeight, size(), generations, localSize,
+                       steps, events);
+    times = profile(events);
+  }
+
+  unsigned threads() const override {
+    return static_cast<unsigned>(localSize[0] * localSize[1]);
+  }
+
+private:
+  cl_uint steps;
+  size_t localSize[2];
+};
+
+static const bool openClEnginesRegistered = [] {
+  registerEngine("opencl", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new OpenClEngine("OpenCL", "simpleLifeKernel", 1, options));
+  });
+  registerEngine("opencl-ifs", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new OpenClEngine("OpenCL Ifs", "simpleLifeKernelIfs", 1, options));
+  });
+  registerEngine("opencl-2d", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new OpenClEngine("OpenCL 2D", "simpleLifeKernel2D", 2, options));
+  });
+  registerEngine("opencl-tiled", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(new OpenClTiledEngine(options));
+  });
+  return true;
+}();
@@ -0,0 +1,241 @@
+#include "pattern.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char snapshotMagic[8] = {'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P'};
+static const size_t snapshotAlignment = 64;
+
+// Pattern files
+void readRle(std::istream &in, ubyte *data, size_t width, size_t height,
+             size_t x, size_t y) {
+  // Skip comments and the "x = m, y = n, rule = ..." header line
+  while (in >> std::ws && (in.peek() == '#' || in.peek() == 'x'))
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+  size_t column = 0, row = 0, run = 0;
+  for (int c; (c = in.get()) != EOF && c != '!';) {
+    if (std::isdigit(c)) {
+      run = run * 10 + (c - '0');
+      continue;
+    }
+    if (std::isspace(c))
+      continue;
+
+    size_t count = run ? run : 1;
+    run = 0;
+    if (c == '$') {
+      row += count;
+      column = 0;
+    } else if (c == 'b' || c == '.') {
+      column += count;
+    } else if (std::isalpha(c)) {
+      // Any other state letter counts as alive
+      size_t cellY = (y + row) % height;
+      for (size_t i = 0; i < count; ++i, ++column)
+        data[cellY * width + (x + column) % width] = 1;
+    } else {
+      throw std::runtime_error(std::string("[Pattern] Unexpected RLE tag '") +
+                               char(c) + "'.");
+    }
+  }
+}
+
+void readCells(std::istream &in, ubyte *data, size_t width, size_t height,
+               size_t x, size_t y) {
+  size_t row = 0;
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty() && line[0] == '!')
+      continue;
+    size_t cellY = (y + row++) % height;
+    for (size_t column = 0; column < line.size(); ++column)
+      if (line[column] == 'O' || line[column] == '*')
+        data[cellY * width + (x + column) % width] = 1;
+  }
+}
+
+void loadPattern(const std::string &path, ubyte *data, size_t width,
+                 size_t height, size_t x, size_t y) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("[Pattern] Cannot open " + path + '.');
+
+  auto endsWith = [&](const char *suffix) {
+    size_t n = std::strlen(suffix);
+    return path.size() >= n && path.compare(path.size() - n, n, suffix) == 0;
+  };
+  if (endsWith(".rle"))
+    readRle(in, data, width, height, x, y);
+  else if (endsWith(".cells"))
+    readCells(in, data, width, height, x, y);
+  else
+    throw std::runtime_error("[Pattern] Unknown pattern format " + path + '.');
+}
+
+void writeRle(std::ostream &out, const ubyte *data, size_t width,
+              size_t height, const Rule &rule) {
+  out << "x = " << width << ", y = " << height
+      << ", rule = " << ruleString(rule) << '\n';
+
+  // Runs are buffered so lines can be wrapped at 70 characters
+  size_t lineLength = 0;
+  auto emit = [&](size_t count, char tag) {
+    std::string run = (count > 1 ? std::to_string(count) : "") + tag;
+    if (lineLength + run.size() > 70) {
+      out << '\n';
+      lineLength = 0;
+    }
+    out << run;
+    lineLength += run.size();
+  };
+
+  size_t pendingRows = 0;
+  for (size_t y = 0; y < height; ++y) {
+    const ubyte *row = data + y * width;
+    size_t end = width;
+    while (end > 0 && !row[end - 1])
+      --end;
+    if (end == 0) {
+      ++pendingRows;
+      continue;
+    }
+
+    if (pendingRows > 0)
+      emit(pendingRows, '$');
+    pendingRows = 1;
+    for (size_t x = 0; x < end;) {
+      size_t runEnd = x;
+      while (runEnd < end && row[runEnd] == row[x])
+        ++runEnd;
+      emit(runEnd - x, row[x] ? 'o' : 'b');
+      x = runEnd;
+    }
+  }
+  out << "!\n";
+}
+
+// Snapshots
+SnapshotHeader snapshotHeader(size_t width, size_t height,
+                              uint64_t generation) {
+  SnapshotHeader header = {};
+  std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+  header.version = snapshotVersion;
+  header.headerSize = (sizeof(SnapshotHeader) + snapshotAlignment - 1) /
+                      snapshotAlignment * snapshotAlignment;
+  header.width = width;
+  header.height = height;
+  header.generation = generation;
+  header.wordsPerRow = (width + 63) / 64;
+  return header;
+}
+
+bool isSnapshotHeader(const SnapshotHeader &header, size_t fileSize) {
+  if (fileSize < sizeof(SnapshotHeader) ||
+      std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 ||
+      header.version != snapshotVersion ||
+      header.wordsPerRow != (header.width + 63) / 64 ||
+      header.headerSize % snapshotAlignment != 0 ||
+      header.headerSize < sizeof(SnapshotHeader) ||
+      header.headerSize > fileSize)
+    return false;
+  // Overflow safe form of headerSize + height * wordsPerRow * 8 <= fileSize
+  size_t rowSize = header.wordsPerRow * sizeof(uint64_t);
+  return rowSize == 0 || (header.height <= (fileSize - header.headerSize) /
+                                               rowSize);
+}
+
+static size_t writeSnapshotHeader(std::ofstream &out, const std::string &path,
+                                  size_t width, size_t height,
+                                  uint64_t generation) {
+  if (!out)
+    throw std::runtime_error("[Pattern] Cannot create " + path + '.');
+
+  SnapshotHeader header = snapshotHeader(width, height, generation);
+
+  std::vector<char> padding(header.headerSize - sizeof(header), 0);
+  out.write((const char *)&header, sizeof(header));
+  out.write(padding.data(), padding.size());
+  return header.wordsPerRow;
+}
+
+void writeSnapshot(const std::string &path, const ubyte *data, size_t width,
+                   size_t height, uint64_t generation) {
+  std::ofstream out(path, std::ios::binary);
+  size_t wordsPerRow =
+      writeSnapshotHeader(out, path, width, height, generation);
+
+  std::vector<uint64_t> words(wordsPerRow);
+  for (size_t y = 0; y < height; ++y) {
+    const ubyte *cells = data + y * width;
+    std::fill(words.begin(), words.end(), 0);
+    for (size_t x = 0; x < width; ++x)
+      words[x / 64] |= (uint64_t)(cells[x] & 1) << (x % 64);
+    out.write((const char *)words.data(), wordsPerRow * sizeof(uint64_t));
+  }
+
+  if (!out)
+    throw std::runtime_error("[Pattern] Failed writing " + path + '.');
+}
+
+void writeSnapshotPacked(const std::string &path, const uint64_t *words,
+                         size_t width, size_t height, uint64_t generation) {
+  std::ofstream out(path, std::ios::binary);
+  size_t wordsPerRow =
+      writeSnapshotHeader(out, path, width, height, generation);
+  out.write((const char *)words, height * wordsPerRow * sizeof(uint64_t));
+
+  if (!out)
+    throw std::runtime_error("[Pattern] Failed writing " + path + '.');
+}
+
+Snapshot::Snapshot(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("[Pattern] Cannot open " + path + '.');
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    throw std::runtime_error("[Pattern] " + path + " is not a snapshot.");
+  }
+
+  mappingSize = info.st_size;
+  mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw std::runtime_error("[Pattern] Cannot map " + path + '.');
+  }
+  madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+  header = (const SnapshotHeader *)mapping;
+  if (!isSnapshotHeader(*header, mappingSize)) {
+    munmap(mapping, mappingSize);
+    throw std::runtime_error("[Pattern] " + path +
+                             " is not a supported snapshot.");
+  }
+  words = (const uint64_t *)((const char *)mapping + header->headerSize);
+}
+
+Snapshot::~Snapshot() {
+  if (mapping)
+    munmap(mapping, mappingSize);
+}
+
+void Snapshot::unpack(ubyte *data) const {
+  for (size_t y = 0; y < height(); ++y) {
+    const uint64_t *words = row(y);
+    ubyte *cells = data + y * width();
+    for (size_t x = 0; x < width(); ++x)
+      cells[x] = (words[x / 64] >> (x % 64)) & 1;
+  }
+}
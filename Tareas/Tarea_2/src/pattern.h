@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "rule.h"
+
+typedef unsigned char ubyte;
+
+// Pattern files are placed with their top-left corner at (x, y) and wrap
+// around the edges of the world. Both readers stream the input, so the
+// pattern never has to fit in memory as text.
+void readRle(std::istream &in, ubyte *data, size_t width, size_t height,
+             size_t x, size_t y);
+void readCells(std::istream &in, ubyte *data, size_t width, size_t height,
+               size_t x, size_t y);
+void loadPattern(const std::string &path, ubyte *data, size_t width,
+                 size_t height, size_t x, size_t y); // By extension
+void writeRle(std::ostream &out, const ubyte *data, size_t width,
+              size_t height, const Rule &rule = conwayRule);
+
+// Binary snapshots store every row as ceil(width / 64) words in the native
+// byte order, bit i of word w holding cell 64 * w + i, the same layout the
+// bit-packed engine uses, so the engine reads them in place. Rows start
+// after a header padded to 64 bytes. The header is native too; a snapshot
+// from a machine of the other byte order fails the version check.
+struct SnapshotHeader {
+  char magic[8];       // "LIFESNAP"
+  uint32_t version;    // snapshotVersion
+  uint32_t headerSize; // Offset of the first row
+  uint64_t width;
+  uint64_t height;
+  uint64_t generation;
+  uint64_t wordsPerRow;
+};
+
+const uint32_t snapshotVersion = 1;
+
+SnapshotHeader snapshotHeader(size_t width, size_t height,
+                              uint64_t generation);
+// Whether `header` starts a supported snapshot of `fileSize` bytes
+bool isSnapshotHeader(const SnapshotHeader &header, size_t fileSize);
+
+void writeSnapshot(const std::string &path, const ubyte *data, size_t width,
+                   size_t height, uint64_t generation);
+void writeSnapshotPacked(const std::string &path, const uint64_t *words,
+                         size_t width, size_t height, uint64_t generation);
+
+// Read-only view of a snapshot mapped straight from the file, rows are used
+// in place without reading or parsing the file.
+class Snapshot {
+public:
+  explicit Snapshot(const std::string &path);
+  Snapshot(const Snapshot &) = delete;
+  Snapshot &operator=(const Snapshot &) = delete;
+  ~Snapshot();
+
+  size_t width() const { return header->width; }
+  size_t height() const { return header->height; }
+  uint64_t generation() const { return header->generation; }
+  size_t wordsPerRow() const { return header->wordsPerRow; }
+  const uint64_t *row(size_t y) const { return words + y * wordsPerRow(); }
+
+  void unpack(ubyte *data) const; // Into the flat row-major layout
+
+private:
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+  const SnapshotHeader *header = nullptr;
+  const uint64_t *words = nullptr;
+};
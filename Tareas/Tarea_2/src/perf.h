@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum PerfEvent {
+  perfCycles,
+  perfInstructions,
+  perfLlcMisses,
+  perfBranchMisses,
+  perfEventCount
+};
+
+const char *const perfEventNames[perfEventCount] = {
+    "cycles", "instructions", "llc-misses", "branch-misses"};
+
+// Counts accumulated over any number of start/stop windows. An event the
+// kernel refused stays unavailable and reads as zero.
+struct PerfTotals {
+  uint64_t value[perfEventCount] = {};
+  bool available[perfEventCount] = {};
+};
+
+// Hardware counters of the calling thread through perf_event_open, opened as
+// one group so every event covers the same window. Threads that already
+// exist (the BandPool workers) are not counted, so reports leave the
+// counters of multi-threaded rows empty. Containers and a strict
+// perf_event_paranoid usually refuse some or all events, in which case the
+// counters quietly count less or nothing at all.
+class PerfCounters {
+public:
+  PerfCounters() {
+#ifdef __linux__
+    const uint64_t configs[perfEventCount] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (int event = 0; event < perfEventCount; ++event) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[event];
+      attr.disabled = leader < 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fd < 0) {
+        if (reason.empty())
+          reason = std::string(perfEventNames[event]) + ": " +
+                   std::strerror(errno);
+        continue;
+      }
+      if (leader < 0)
+        leader = fd;
+      fds[event] = fd;
+      slot[event] = opened++;
+    }
+#else
+    reason = "perf_event_open needs Linux";
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds)
+      if (fd >= 0)
+        close(fd);
+#endif
+  }
+
+  bool available() const { return opened > 0; }
+
+  // Available events, or why there are none
+  std::string describe() const {
+    std::string text;
+    for (int event = 0; event < perfEventCount; ++event)
+      if (fds[event] >= 0)
+        text += (text.empty() ? "" : ",") + std::string(perfEventNames[event]);
+    if (text.empty())
+      return "unavailable (" + reason + ')';
+    return text;
+  }
+
+  void start() {
+#ifdef __linux__
+    if (leader >= 0) {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  // Adds the window since start() to `totals`, scaled up when the kernel had
+  // to multiplex the group with other events
+  void stop(PerfTotals &totals) {
+#ifdef __linux__
+    if (leader < 0)
+      return;
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    uint64_t buffer[3 + perfEventCount];
+    ssize_t size = read(leader, buffer, sizeof(buffer));
+    if (size < ssize_t((3 + opened) * sizeof(uint64_t)) || buffer[0] != opened)
+      return;
+    double scale = buffer[2] > 0 ? double(buffer[1]) / buffer[2] : 0;
+    for (int event = 0; event < perfEventCount; ++event)
+      if (fds[event] >= 0) {
+        totals.value[event] += uint64_t(buffer[3 + slot[event]] * scale);
+        totals.available[event] = true;
+      }
+#else
+    (void)totals;
+#endif
+  }
+
+private:
+  int fds[perfEventCount] = {-1, -1, -1, -1};
+  unsigned slot[perfEventCount] = {};
+  unsigned opened = 0;
+  int leader = -1;
+  std::string reason;
+};
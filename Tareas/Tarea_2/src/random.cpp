@@ -0,0 +1,183 @@
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+bool parseRandomMode(const std::string &text, RandomMode &mode) {
+  if (text == "lcg")
+    mode = randomLcg;
+  else if (text == "philox")
+    mode = randomPhilox;
+  else
+    return false;
+  return true;
+}
+
+const char *randomModeName(RandomMode mode) {
+  return mode == randomPhilox ? "philox" : "lcg";
+}
+
+// A cell is alive when rotl(x, 7) + density * 2^32 carries out of 32 bits,
+// that is when rotl(x, 7) >= 2^32 - density * 2^32. With density 0.5 this
+// is bit 24 of x, the original (x >> 24) & 1. Density 0 has no limit.
+static bool densityLimit(double density, uint32_t &limit) {
+  density = std::min(1.0, std::max(0.0, density));
+  uint64_t threshold = std::llround(density * 4294967296.0);
+  limit = uint32_t((uint64_t(1) << 32) - threshold);
+  return threshold > 0;
+}
+
+// Compared as signed after flipping the top bit, which SSE2 can do
+static inline ubyte alive(uint32_t x, uint32_t limit) {
+  uint32_t rotated = (x << 7) | (x >> 25);
+  return int32_t(rotated ^ 0x80000000u) >= int32_t(limit ^ 0x80000000u);
+}
+
+// Only the low 32 bits of the index reach the LCG
+static inline uint32_t lcg(uint32_t i, unsigned seed) {
+  uint32_t x = i ^ seed;
+  return x * 1664525u + 1013904223u;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 32 LCG cells per iteration, four vectors of eight packed down to bytes.
+// Returns how many cells it filled, the rest is left to the scalar loop.
+__attribute__((target("avx2"))) static size_t
+fillLcgAvx2(ubyte *data, uint32_t start, size_t count, unsigned seed,
+            uint32_t limit) {
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i seeds = _mm256_set1_epi32(int(seed));
+  const __m256i multiplier = _mm256_set1_epi32(1664525);
+  const __m256i increment = _mm256_set1_epi32(1013904223);
+  const __m256i flip = _mm256_set1_epi32(int(0x80000000u));
+  const __m256i limits = _mm256_set1_epi32(int(limit ^ 0x80000000u));
+  const __m256i one = _mm256_set1_epi32(1);
+  // The packs work per 128-bit lane, this puts the dwords back in order
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  size_t j = 0;
+  for (; j + 32 <= count; j += 32) {
+    __m256i cells[4];
+    for (int k = 0; k < 4; ++k) {
+      __m256i x = _mm256_add_epi32(
+          _mm256_set1_epi32(int(start + uint32_t(j) + 8 * k)), lanes);
+      x = _mm256_xor_si256(x, seeds);
+      x = _mm256_add_epi32(_mm256_mullo_epi32(x, multiplier), increment);
+      __m256i rotated =
+          _mm256_or_si256(_mm256_slli_epi32(x, 7), _mm256_srli_epi32(x, 25));
+      __m256i dead =
+          _mm256_cmpgt_epi32(limits, _mm256_xor_si256(rotated, flip));
+      cells[k] = _mm256_andnot_si256(dead, one);
+    }
+    __m256i bytes =
+        _mm256_packs_epi16(_mm256_packs_epi32(cells[0], cells[1]),
+                           _mm256_packs_epi32(cells[2], cells[3]));
+    _mm256_storeu_si256((__m256i *)(data + j),
+                        _mm256_permutevar8x32_epi32(bytes, order));
+  }
+  return j;
+}
+
+static bool hasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+// Philox4x32-10, counter (i, 0) and key (seed, 0) give four words
+static inline void philox(uint64_t counter, unsigned seed, uint32_t out[4]) {
+  uint32_t c0 = uint32_t(counter), c1 = uint32_t(counter >> 32), c2 = 0,
+           c3 = 0;
+  uint32_t k0 = seed, k1 = 0;
+  for (int round = 0; round < 10; ++round) {
+    uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+    uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+    uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+    c1 = uint32_t(p1);
+    c3 = uint32_t(p0);
+    c0 = n0;
+    c2 = n2;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void fillRandomCells(ubyte *data, uint64_t first, size_t count,
+                     const RandomOptions &options) {
+  uint32_t limit;
+  if (!densityLimit(options.density, limit)) {
+    std::fill(data, data + count, 0);
+    return;
+  }
+  const unsigned seed = options.seed;
+
+  if (options.mode == randomLcg) {
+    const uint32_t start = uint32_t(first);
+    size_t j = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool avx2 = hasAvx2();
+    if (avx2)
+      j = fillLcgAvx2(data, start, count, seed, limit);
+#endif
+    for (; j < count; ++j)
+      data[j] = alive(lcg(start + uint32_t(j), seed), limit);
+    return;
+  }
+
+  // Cell i takes word i % 4 of counter i / 4
+  uint32_t words[4];
+  for (size_t j = 0; j < count;) {
+    uint64_t i = first + j;
+    philox(i / 4, seed, words);
+    for (unsigned w = i % 4; w < 4 && j < count; ++w, ++j)
+      data[j] = alive(words[w], limit);
+  }
+}
+
+void fillRandomBits(uint64_t *words, uint64_t first, size_t count,
+                    const RandomOptions &options) {
+  ubyte cells[64];
+  for (size_t j = 0; j < count; j += 64) {
+    size_t n = std::min<size_t>(64, count - j);
+    fillRandomCells(cells, first + j, n, options);
+    uint64_t word = 0;
+    for (size_t b = 0; b < n; ++b)
+      word |= uint64_t(cells[b]) << b;
+    words[j / 64] = word;
+  }
+}
+
+void fillRandomWorld(ubyte *data, size_t size, const RandomOptions &options,
+                     unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  // Small worlds are not worth starting threads for
+  const size_t minChunk = size_t(1) << 20;
+  threads = unsigned(std::min<size_t>(threads, size / minChunk + 1));
+  if (threads == 1) {
+    fillRandomCells(data, 0, size, options);
+    return;
+  }
+
+  size_t chunk = (size + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    size_t begin = std::min(size, t * chunk);
+    size_t end = std::min(size, begin + chunk);
+    workers.emplace_back(fillRandomCells, data + begin, begin, end - begin,
+                         std::cref(options));
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+}
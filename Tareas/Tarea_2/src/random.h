@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+typedef unsigned char ubyte;
+
+// Counter-based world generators: cell i depends only on i and the seed, so
+// every backend, thread split and layout fills the same world. The LCG mode
+// is the i ^ seed LCG the GPU programs once filled their worlds with,
+// Philox4x32-10 trades speed for statistically independent cells.
+enum RandomMode { randomLcg, randomPhilox };
+
+struct RandomOptions {
+  unsigned seed = 0;
+  double density = 0.5; // Fraction of alive cells
+  RandomMode mode = randomLcg;
+};
+
+bool parseRandomMode(const std::string &text, RandomMode &mode);
+const char *randomModeName(RandomMode mode);
+
+// Cells [first, first + count) of the world, one per byte
+void fillRandomCells(ubyte *data, uint64_t first, size_t count,
+                     const RandomOptions &options);
+// The same cells one per bit in ceil(count / 64) words, bit i of word w
+// holding cell first + 64 * w + i and the bits past count cleared
+void fillRandomBits(uint64_t *words, uint64_t first, size_t count,
+                    const RandomOptions &options);
+// Whole flat world, split over `threads` threads (0 uses every core)
+void fillRandomWorld(ubyte *data, size_t size, const RandomOptions &options,
+                     unsigned threads = 0);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Outer-totalistic rule, bit n of a mask is set when a cell with n alive
+// neighbours is born (dead cells) or survives (alive cells).
+struct Rule {
+  uint16_t birth;
+  uint16_t survival;
+};
+
+constexpr uint16_t neighbours(std::initializer_list<int> counts) {
+  uint16_t mask = 0;
+  for (int count : counts)
+    mask |= 1 << count;
+  return mask;
+}
+
+constexpr Rule conwayRule = {neighbours({3}), neighbours({2, 3})};
+constexpr Rule highLifeRule = {neighbours({3, 6}), neighbours({2, 3})};
+constexpr Rule dayAndNightRule = {neighbours({3, 6, 7, 8}),
+                                  neighbours({3, 4, 6, 7, 8})};
+constexpr Rule seedsRule = {neighbours({2}), 0};
+
+inline bool operator==(const Rule &a, const Rule &b) {
+  return a.birth == b.birth && a.survival == b.survival;
+}
+
+// Accepts "B36/S23" (any case) and the older survival-first "23/36"
+inline bool parseRule(const std::string &text, Rule &rule) {
+  size_t slash = text.find('/');
+  if (slash == std::string::npos)
+    return false;
+
+  std::string first = text.substr(0, slash), second = text.substr(slash + 1);
+  bool tagged = !first.empty() && std::toupper(first[0]) == 'B';
+  if (tagged && (second.empty() || std::toupper(second[0]) != 'S'))
+    return false;
+  if (tagged) {
+    first.erase(0, 1);
+    second.erase(0, 1);
+  }
+
+  auto parseMask = [](const std::string &digits, uint16_t &mask) {
+    mask = 0;
+    for (char digit : digits) {
+      if (digit < '0' || digit > '8')
+        return false;
+      mask |= 1 << (digit - '0');
+    }
+    return true;
+  };
+  return tagged ? parseMask(first, rule.birth) &&
+                      parseMask(second, rule.survival)
+                : parseMask(first, rule.survival) &&
+                      parseMask(second, rule.birth);
+}
+
+inline std::string ruleString(const Rule &rule) {
+  std::string text = "B";
+  for (int n = 0; n <= 8; ++n)
+    if (rule.birth >> n & 1)
+      text += char('0' + n);
+  text += "/S";
+  for (int n = 0; n <= 8; ++n)
+    if (rule.survival >> n & 1)
+      text += char('0' + n);
+  return text;
+}
+
+inline unsigned char nextState(const Rule &rule, unsigned alive,
+                               unsigned char self) {
+  return ((self ? rule.survival : rule.birth) >> alive) & 1;
+}
@@ -1,33 +1,323 @@
+#include "bench.h"
+#include "bitboard.h"
+#include "block.h"
+#include "cluster.h"
+#include "cycle.h"
+#include "engine.h"
+#include "grid.h"
+#include "hashlife.h"
+#include "pattern.h"
+#include "random.h"
+#include "rule.h"
+#include "stats.h"
+#include "stream.h"
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 typedef unsigned char ubyte;
 
-ubyte *m_data;
-ubyte *m_resultData;
+ubyte *m_data = nullptr;
+ubyte *m_resultData = nullptr;
+
+// Array of row pointers with a separate allocation per row, kept to compare
+// against the pitched Grid layout.
+ubyte **m_data2D = nullptr;
+ubyte **m_resultData2D = nullptr;
+
+uint64_t *m_bitData = nullptr;
+uint64_t *m_bitResultData = nullptr;
+size_t m_wordsPerRow;
+// Rows the next bitboard generation reads instead of m_bitData, so a run
+// restored from a snapshot starts from the mapped file without a copy
+const uint64_t *m_bitSource = nullptr;
+
+// XOR of the cellKey of every cell the last generation changed, see cycle.h.
+// Only the simulation driver turns it on.
+bool m_hashChanges = false;
+uint64_t m_changesHash = 0;
+
+// Births, deaths and tile populations of the last generation, gathered by
+// the simulation loops when set. See stats.h.
+StatsTally *m_stats = nullptr;
+
+// 2x2 blocks of cells, advanced through a table for the current rule. See
+// block.h for the layout.
+ubyte *m_blockData = nullptr;
+ubyte *m_blockResultData = nullptr;
+size_t m_blocksPerRow;
+size_t m_blockRows;
+const BlockTable *m_blockTable = nullptr; // Built for m_rule on first use
+
+// Pitched grids with ghost cells around the world, used by the 2D and SIMD
+// engines.
+Grid m_grid;
+Grid m_gridResult;
+
+typedef void (*HaloRowKernel)(const ubyte *up, const ubyte *mid,
+                              const ubyte *down, ubyte *result, size_t width);
+HaloRowKernel m_haloRowKernel;
+
+// Temporal blocking advances each tile m_temporalSteps generations before
+// writing it back, the tile plus its ghost zone should fit in L2.
+const size_t temporalTileWidth = 512;
+const size_t temporalTileHeight = 128;
+size_t m_temporalSteps = 1;
+std::vector<ubyte> m_tileData;
+std::vector<ubyte> m_tileResultData;
+
+// Active region tracking over 64x64 tiles. A tile is skipped when neither it
+// nor its neighbours changed since the last generation (still lifes), or
+// since two generations ago (period 2 oscillators). In both cases the result
+// buffer already holds the right cells.
+const size_t activeTileSize = 64;
+size_t m_activeTilesX;
+size_t m_activeTilesY;
+std::vector<ubyte> m_tileChanged1; // Generation t differs from t - 1
+std::vector<ubyte> m_tileChanged2; // Generation t differs from t - 2
+std::vector<ubyte> m_nextTileChanged1;
+std::vector<ubyte> m_nextTileChanged2;
+int m_activeWarmup;
+size_t m_activeSkipped;
+
+Hashlife m_hashlife;
+unsigned m_hashlifeStep = 4; // Each call advances 2^m_hashlifeStep
+
+void randomizeWorld();
+void (*m_seedWorld)(void) = randomizeWorld;
+
+std::string m_patternPath;
+size_t m_patternX = 0;
+size_t m_patternY = 0;
+
+BenchOptions m_bench;
+
+// Blocks until `count` threads have called wait(), std::barrier is C++20.
+class Barrier {
+public:
+  explicit Barrier(size_t count) : count(count) {}
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t arrival = generation;
+    if (++waiting == count) {
+      waiting = 0;
+      ++generation;
+      cv.notify_all();
+    } else {
+      cv.wait(lock, [&] { return arrival != generation; });
+    }
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t count;
+  size_t waiting = 0;
+  size_t generation = 0;
+};
+
+// Persistent workers that split [0, rows) into bands every generation. Each
+// worker starts on its own queue of bands and steals from the others once it
+// runs dry. The calling thread works as worker 0.
+class BandPool {
+public:
+  explicit BandPool(unsigned threads)
+      : threadCount(threads), queues(new BandQueue[threads]), start(threads),
+        done(threads) {
+    for (unsigned id = 1; id < threadCount; ++id)
+      workers.emplace_back(&BandPool::workerLoop, this, id);
+  }
+
+  ~BandPool() {
+    stopping = true;
+    start.wait();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+  unsigned size() const { return threadCount; }
+
+  void run(void (*work)(size_t, size_t), size_t rows) {
+    size_t bands = std::min(rows, (size_t)threadCount * bandsPerThread);
+    this->work = work;
+    this->rows = rows;
+    bandRows = (rows + bands - 1) / bands;
+    bands = (rows + bandRows - 1) / bandRows;
+
+    for (unsigned id = 0; id < threadCount; ++id) {
+      queues[id].next.store(id * bands / threadCount,
+                            std::memory_order_relaxed);
+      queues[id].end = (id + 1) * bands / threadCount;
+    }
+
+    start.wait();
+    drain(0);
+    done.wait();
+  }
+
+private:
+  static constexpr size_t bandsPerThread = 4;
+
+  struct alignas(64) BandQueue {
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+  };
+
+  void workerLoop(unsigned id) {
+    while (true) {
+      start.wait();
+      if (stopping)
+        return;
+      drain(id);
+      done.wait();
+    }
+  }
+
+  void drain(unsigned id) {
+    for (unsigned k = 0; k < threadCount; ++k) {
+      BandQueue &queue = queues[(id + k) % threadCount];
+      // Owner and thieves claim bands from the same counter, so every band
+      // is computed exactly once.
+      for (size_t band;
+           (band = queue.next.fetch_add(1, std::memory_order_relaxed)) <
+           queue.end;) {
+        size_t yBegin = band * bandRows;
+        work(yBegin, std::min(rows, yBegin + bandRows));
+      }
+    }
+  }
+
+  unsigned threadCount;
+  std::unique_ptr<BandQueue[]> queues;
+  std::vector<std::thread> workers;
+  Barrier start;
+  Barrier done;
+  void (*work)(size_t, size_t) = nullptr;
+  size_t rows = 0;
+  size_t bandRows = 1;
+  bool stopping = false;
+};
 
-ubyte **m_data2D;
-ubyte **m_resultData2D;
+BandPool *m_pool = nullptr;
+unsigned m_threadCount = std::max(1u, std::thread::hardware_concurrency());
 
 size_t m_worldWidth;
 size_t m_worldHeight;
 size_t m_dataLength;
 
+Rule m_rule = conwayRule;
+
 void randomizeWorld() {
-  for (int i = 0; i < m_dataLength; ++i)
-    m_data[i] = rand() % 2;
+  fillRandomWorld(m_data, m_dataLength, m_bench.world, m_threadCount);
+  ++m_bench.world.seed;
+}
+
+void seedPatternWorld() {
+  std::fill(m_data, m_data + m_dataLength, 0);
+  loadPattern(m_patternPath, m_data, m_worldWidth, m_worldHeight, m_patternX,
+              m_patternY);
 }
 
-void randomizeWorld2D() {
+// A random 32x32 patch repeated over the whole world
+void seedPeriodicWorld() {
+  ubyte patch[32][32];
+  for (size_t y = 0; y < 32; ++y)
+    for (size_t x = 0; x < 32; ++x)
+      patch[y][x] = rand() % 2;
+
   for (size_t y = 0; y < m_worldHeight; ++y)
     for (size_t x = 0; x < m_worldWidth; ++x)
-      m_data2D[y][x] = rand() % 2;
+      m_data[y * m_worldWidth + x] = patch[y % 32][x % 32];
+}
+
+// Blocks, blinkers and gliders scattered on a 64 cell lattice
+void seedStructuredWorld() {
+  static const ubyte shapes[3][3][3] = {
+      {{1, 1, 0}, {1, 1, 0}, {0, 0, 0}},
+      {{0, 1, 0}, {0, 1, 0}, {0, 1, 0}},
+      {{0, 1, 0}, {0, 0, 1}, {1, 1, 1}},
+  };
+
+  std::fill(m_data, m_data + m_dataLength, 0);
+  for (size_t y = 0; y + 3 <= m_worldHeight; y += 64) {
+    for (size_t x = 0; x + 3 <= m_worldWidth; x += 64) {
+      int shape = rand() % 4;
+      if (shape == 3)
+        continue;
+      for (size_t dy = 0; dy < 3; ++dy)
+        for (size_t dx = 0; dx < 3; ++dx)
+          m_data[(y + dy) * m_worldWidth + x + dx] = shapes[shape][dy][dx];
+    }
+  }
+}
+
+// Bit i of word w in a packed row holds the cell at x = 64 * w + i.
+void packWorld() {
+  for (size_t y = 0; y < m_worldHeight; ++y) {
+    for (size_t w = 0; w < m_wordsPerRow; ++w) {
+      const ubyte *cells = m_data + y * m_worldWidth + w * 64;
+      uint64_t word = 0;
+      for (size_t i = 0; i < 64; ++i)
+        word |= (uint64_t)cells[i] << i;
+      m_bitData[y * m_wordsPerRow + w] = word;
+    }
+  }
+}
+
+void unpackWorld() {
+  for (size_t y = 0; y < m_worldHeight; ++y) {
+    for (size_t w = 0; w < m_wordsPerRow; ++w) {
+      ubyte *cells = m_data + y * m_worldWidth + w * 64;
+      uint64_t word = m_bitData[y * m_wordsPerRow + w];
+      for (size_t i = 0; i < 64; ++i)
+        cells[i] = (word >> i) & 1;
+    }
+  }
+}
+
+void packBlocks() {
+  for (size_t by = 0; by < m_blockRows; ++by) {
+    const ubyte *top = m_data + 2 * by * m_worldWidth;
+    const ubyte *bottom = top + m_worldWidth;
+    for (size_t bx = 0; bx < m_blocksPerRow; ++bx)
+      m_blockData[by * m_blocksPerRow + bx] =
+          top[2 * bx] | top[2 * bx + 1] << 1 | bottom[2 * bx] << 2 |
+          bottom[2 * bx + 1] << 3;
+  }
+}
+
+void unpackBlocks() {
+  for (size_t by = 0; by < m_blockRows; ++by) {
+    ubyte *top = m_data + 2 * by * m_worldWidth;
+    ubyte *bottom = top + m_worldWidth;
+    for (size_t bx = 0; bx < m_blocksPerRow; ++bx) {
+      ubyte block = m_blockData[by * m_blocksPerRow + bx];
+      top[2 * bx] = block & 1;
+      top[2 * bx + 1] = block >> 1 & 1;
+      bottom[2 * bx] = block >> 2 & 1;
+      bottom[2 * bx + 1] = block >> 3 & 1;
+    }
+  }
 }
 
 inline ubyte countAliveCells(size_t x0, size_t x1, size_t x2, size_t y0,
@@ -65,24 +355,449 @@ inline ubyte countAliveCells2D(size_t x0, size_t x1, size_t x2, size_t y0,
          m_data2D[y2][x1] + m_data2D[y2][x2];
 }
 
+// The masks are compile-time constants for the common rules, so the next
+// state folds into a shift of a constant. Other rules read m_rule.
+template <uint16_t Birth, uint16_t Survival>
+void computeRowsSerial(size_t yBegin, size_t yEnd) {
+  for (size_t y = yBegin; y < yEnd; ++y) {
+    size_t y0 = ((y + m_worldHeight - 1) % m_worldHeight) * m_worldWidth;
+    size_t y1 = y * m_worldWidth;
+    size_t y2 = ((y + 1) % m_worldHeight) * m_worldWidth;
+
+    for (size_t x = 0; x < m_worldWidth; ++x) {
+      size_t x0 = (x + m_worldWidth - 1) % m_worldWidth;
+      size_t x2 = (x + 1) % m_worldWidth;
+
+      ubyte aliveCells = countAliveCells(x0, x, x2, y0, y1, y2);
+      m_resultData[y1 + x] =
+          ((m_data[x + y1] ? Survival : Birth) >> aliveCells) & 1;
+    }
+  }
+}
+
+void computeRowsSerialGeneric(size_t yBegin, size_t yEnd) {
+  const Rule rule = m_rule;
+  for (size_t y = yBegin; y < yEnd; ++y) {
+    size_t y0 = ((y + m_worldHeight - 1) % m_worldHeight) * m_worldWidth;
+    size_t y1 = y * m_worldWidth;
+    size_t y2 = ((y + 1) % m_worldHeight) * m_worldWidth;
+
+    for (size_t x = 0; x < m_worldWidth; ++x) {
+      size_t x0 = (x + m_worldWidth - 1) % m_worldWidth;
+      size_t x2 = (x + 1) % m_worldWidth;
+
+      ubyte aliveCells = countAliveCells(x0, x, x2, y0, y1, y2);
+      m_resultData[y1 + x] = nextState(rule, aliveCells, m_data[x + y1]);
+    }
+  }
+}
+
+void (*m_computeRowsSerial)(size_t, size_t) =
+    computeRowsSerial<conwayRule.birth, conwayRule.survival>;
+
+void selectRule(const Rule &rule) {
+  struct RuleKernel {
+    Rule rule;
+    void (*rows)(size_t, size_t);
+  };
+  static const RuleKernel kernels[] = {
+      {conwayRule, computeRowsSerial<conwayRule.birth, conwayRule.survival>},
+      {highLifeRule,
+       computeRowsSerial<highLifeRule.birth, highLifeRule.survival>},
+      {dayAndNightRule,
+       computeRowsSerial<dayAndNightRule.birth, dayAndNightRule.survival>},
+      {seedsRule, computeRowsSerial<seedsRule.birth, seedsRule.survival>},
+  };
+
+  m_rule = rule;
+  m_computeRowsSerial = computeRowsSerialGeneric;
+  for (const RuleKernel &kernel : kernels)
+    if (kernel.rule == rule)
+      m_computeRowsSerial = kernel.rows;
+  m_blockTable = nullptr;
+  m_hashlife.setRule(rule);
+}
+
 void computeIterationSerial() {
+  m_computeRowsSerial(0, m_worldHeight);
+  std::swap(m_data, m_resultData);
+}
+
+void computeIterationParallel() {
+  m_pool->run(m_computeRowsSerial, m_worldHeight);
+  std::swap(m_data, m_resultData);
+}
+
+template <bool Hashed, bool Tallied>
+void computeBitboardRows(const uint64_t *source) {
+  for (size_t y = 0; y < m_worldHeight; ++y)
+    computeBitboardRow<Hashed, Tallied>(
+        source + ((y + m_worldHeight - 1) % m_worldHeight) * m_wordsPerRow,
+        source + y * m_wordsPerRow,
+        source + ((y + 1) % m_worldHeight) * m_wordsPerRow,
+        m_bitResultData + y * m_wordsPerRow, m_wordsPerRow, m_rule,
+        &m_changesHash, y * m_worldWidth, m_stats);
+}
+
+void computeIterationSerialBitboard() {
+  const uint64_t *source = m_bitSource ? m_bitSource : m_bitData;
+  m_changesHash = 0;
+  if (m_stats)
+    m_stats->reset();
+  if (m_hashChanges && m_stats)
+    computeBitboardRows<true, true>(source);
+  else if (m_hashChanges)
+    computeBitboardRows<true, false>(source);
+  else if (m_stats)
+    computeBitboardRows<false, true>(source);
+  else
+    computeBitboardRows<false, false>(source);
+  m_bitSource = nullptr;
+  std::swap(m_bitData, m_bitResultData);
+}
+
+// computeIterationSerial folding every changed cell into m_changesHash and
+// m_stats, whichever are on
+void computeIterationSerialTallied() {
+  const Rule rule = m_rule;
+  const bool hash = m_hashChanges;
+  uint64_t changes = 0, births = 0, deaths = 0;
+  if (m_stats)
+    m_stats->reset();
+
   for (size_t y = 0; y < m_worldHeight; ++y) {
     size_t y0 = ((y + m_worldHeight - 1) % m_worldHeight) * m_worldWidth;
     size_t y1 = y * m_worldWidth;
     size_t y2 = ((y + 1) % m_worldHeight) * m_worldWidth;
+    uint32_t *tiles = m_stats ? m_stats->tileRow(y) : nullptr;
 
     for (size_t x = 0; x < m_worldWidth; ++x) {
       size_t x0 = (x + m_worldWidth - 1) % m_worldWidth;
       size_t x2 = (x + 1) % m_worldWidth;
 
+      ubyte self = m_data[x + y1];
       ubyte aliveCells = countAliveCells(x0, x, x2, y0, y1, y2);
-      m_resultData[y1 + x] =
-          aliveCells == 3 || (aliveCells == 2 && m_data[x + y1]) ? 1 : 0;
+      ubyte cell = nextState(rule, aliveCells, self);
+      if (cell != self) {
+        if (hash)
+          changes ^= cellKey(x + y1);
+        births += cell;
+        deaths += self;
+      }
+      if (tiles)
+        tiles[x / statsTileSize] += cell;
+      m_resultData[x + y1] = cell;
     }
   }
+  m_changesHash = changes;
+  if (m_stats) {
+    m_stats->births = births;
+    m_stats->deaths = deaths;
+  }
   std::swap(m_data, m_resultData);
 }
 
+// One table load per block instead of counting neighbours per cell. The
+// three block rows are walked with a sliding window, so only the ends wrap.
+void computeIterationSerialBlock() {
+  static BlockTable ruleTable;
+  if (!m_blockTable) {
+    makeBlockTable(ruleTable, m_rule);
+    m_blockTable = &ruleTable;
+  }
+  const uint8_t *table = m_blockTable->data();
+  const size_t n = m_blocksPerRow;
+
+  for (size_t by = 0; by < m_blockRows; ++by) {
+    const ubyte *up =
+        m_blockData + ((by + m_blockRows - 1) % m_blockRows) * n;
+    const ubyte *mid = m_blockData + by * n;
+    const ubyte *down = m_blockData + ((by + 1) % m_blockRows) * n;
+    ubyte *result = m_blockResultData + by * n;
+
+    uint32_t upLeft = up[n - 1], upMid = up[0];
+    uint32_t left = mid[n - 1], center = mid[0];
+    uint32_t downLeft = down[n - 1], downMid = down[0];
+    for (size_t bx = 0; bx < n; ++bx) {
+      size_t next = bx + 1 == n ? 0 : bx + 1;
+      uint32_t upRight = up[next], right = mid[next], downRight = down[next];
+
+      result[bx] = table[blockIndex(upLeft, upMid, upRight, left, center,
+                                    right, downLeft, downMid, downRight)];
+
+      upLeft = upMid, upMid = upRight;
+      left = center, center = right;
+      downLeft = downMid, downMid = downRight;
+    }
+  }
+  std::swap(m_blockData, m_blockResultData);
+}
+
+void loadGrid() { m_grid.load(m_data); }
+
+void storeGrid() { m_grid.store(m_data); }
+
+void loadRows2D() {
+  for (size_t y = 0; y < m_worldHeight; ++y)
+    std::memcpy(m_data2D[y], m_data + y * m_worldWidth, m_worldWidth);
+}
+
+void storeRows2D() {
+  for (size_t y = 0; y < m_worldHeight; ++y)
+    std::memcpy(m_data + y * m_worldWidth, m_data2D[y], m_worldWidth);
+}
+
+// Row pointers start at the left ghost column, cell x lives at index x + 1.
+void haloRowScalar(const ubyte *up, const ubyte *mid, const ubyte *down,
+                   ubyte *result, size_t width) {
+  const Rule rule = m_rule;
+  for (size_t x = 0; x < width; ++x) {
+    ubyte alive = up[x] + up[x + 1] + up[x + 2] + mid[x] + mid[x + 2] +
+                  down[x] + down[x + 1] + down[x + 2];
+    result[x + 1] = nextState(rule, alive, mid[x + 1]);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2"))) void
+haloRowSse2(const ubyte *up, const ubyte *mid, const ubyte *down,
+            ubyte *result, size_t width) {
+  // SSE2 has no byte shuffle, so every neighbour count the rule uses is
+  // compared separately.
+  const Rule rule = m_rule;
+  const __m128i one = _mm_set1_epi8(1);
+
+  for (size_t x = 0; x < width; x += 16) {
+    __m128i alive = _mm_add_epi8(
+        _mm_add_epi8(
+            _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up + x)),
+                         _mm_loadu_si128((const __m128i *)(up + x + 1))),
+            _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up + x + 2)),
+                         _mm_loadu_si128((const __m128i *)(mid + x)))),
+        _mm_add_epi8(
+            _mm_add_epi8(_mm_loadu_si128((const __m128i *)(mid + x + 2)),
+                         _mm_loadu_si128((const __m128i *)(down + x))),
+            _mm_add_epi8(_mm_loadu_si128((const __m128i *)(down + x + 1)),
+                         _mm_loadu_si128((const __m128i *)(down + x + 2)))));
+    __m128i self = _mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i *)(mid + x + 1)), one);
+
+    __m128i next = _mm_setzero_si128();
+    for (int n = 0; n <= 8; ++n) {
+      bool born = rule.birth >> n & 1, survives = rule.survival >> n & 1;
+      if (!born && !survives)
+        continue;
+      __m128i count = _mm_cmpeq_epi8(alive, _mm_set1_epi8(n));
+      if (!survives)
+        count = _mm_andnot_si128(self, count);
+      else if (!born)
+        count = _mm_and_si128(self, count);
+      next = _mm_or_si128(next, count);
+    }
+    _mm_storeu_si128((__m128i *)(result + x + 1), _mm_and_si128(next, one));
+  }
+}
+
+__attribute__((target("avx2"))) void
+haloRowAvx2(const ubyte *up, const ubyte *mid, const ubyte *down,
+            ubyte *result, size_t width) {
+  // Next states for 0..8 neighbours, looked up with one byte shuffle each
+  ubyte birth[16] = {}, survival[16] = {};
+  for (int n = 0; n <= 8; ++n) {
+    birth[n] = m_rule.birth >> n & 1;
+    survival[n] = m_rule.survival >> n & 1;
+  }
+  const __m256i birthTable =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)birth));
+  const __m256i survivalTable =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)survival));
+  const __m256i one = _mm256_set1_epi8(1);
+
+  for (size_t x = 0; x < width; x += 32) {
+    __m256i alive = _mm256_add_epi8(
+        _mm256_add_epi8(
+            _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up + x)),
+                            _mm256_loadu_si256((const __m256i *)(up + x + 1))),
+            _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up + x + 2)),
+                            _mm256_loadu_si256((const __m256i *)(mid + x)))),
+        _mm256_add_epi8(
+            _mm256_add_epi8(
+                _mm256_loadu_si256((const __m256i *)(mid + x + 2)),
+                _mm256_loadu_si256((const __m256i *)(down + x))),
+            _mm256_add_epi8(
+                _mm256_loadu_si256((const __m256i *)(down + x + 1)),
+                _mm256_loadu_si256((const __m256i *)(down + x + 2)))));
+    __m256i self = _mm256_loadu_si256((const __m256i *)(mid + x + 1));
+
+    __m256i born = _mm256_shuffle_epi8(birthTable, alive);
+    __m256i survives = _mm256_shuffle_epi8(survivalTable, alive);
+    _mm256_storeu_si256(
+        (__m256i *)(result + x + 1),
+        _mm256_blendv_epi8(born, survives, _mm256_cmpeq_epi8(self, one)));
+  }
+}
+#endif
+
+const char *selectHaloRowKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    m_haloRowKernel = haloRowAvx2;
+    return "AVX2";
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    m_haloRowKernel = haloRowSse2;
+    return "SSE2";
+  }
+#endif
+  m_haloRowKernel = haloRowScalar;
+  return "Scalar";
+}
+
+void computeIterationSerialSimd() {
+  const ptrdiff_t height = m_worldHeight;
+  m_grid.wrapHalo();
+  for (ptrdiff_t y = 0; y < height; ++y)
+    m_haloRowKernel(m_grid.row(y - 1).cells - 1, m_grid.row(y).cells - 1,
+                    m_grid.row(y + 1).cells - 1,
+                    m_gridResult.row(y).cells - 1, m_worldWidth);
+  m_grid.swap(m_gridResult);
+}
+
+void computeIterationSerialTemporal() {
+  size_t k = m_temporalSteps;
+  size_t pitch = ((temporalTileWidth + 2 * k + 31) / 32) * 32 + 32;
+  size_t tileSize = pitch * (temporalTileHeight + 2 * k);
+  if (m_tileData.size() < tileSize) {
+    m_tileData.resize(tileSize);
+    m_tileResultData.resize(tileSize);
+  }
+
+  for (size_t ty = 0; ty < m_worldHeight; ty += temporalTileHeight) {
+    for (size_t tx = 0; tx < m_worldWidth; tx += temporalTileWidth) {
+      size_t th = std::min(temporalTileHeight, m_worldHeight - ty);
+      size_t tw = std::min(temporalTileWidth, m_worldWidth - tx);
+      size_t lh = th + 2 * k;
+      size_t lw = tw + 2 * k;
+
+      // Gather the tile and a k cell ghost zone, wrapping around the world.
+      size_t sy = (ty + k * m_worldHeight - k) % m_worldHeight;
+      size_t sx0 = (tx + k * m_worldWidth - k) % m_worldWidth;
+      for (size_t ly = 0; ly < lh; ++ly) {
+        const ubyte *src = m_data + sy * m_worldWidth;
+        ubyte *dst = m_tileData.data() + ly * pitch;
+        for (size_t lx = 0, sx = sx0; lx < lw; ++lx) {
+          dst[lx] = src[sx];
+          if (++sx == m_worldWidth)
+            sx = 0;
+        }
+        if (++sy == m_worldHeight)
+          sy = 0;
+      }
+
+      // Generation g is only valid g cells away from the tile border.
+      for (size_t g = 1; g <= k; ++g) {
+        for (size_t ly = g; ly < lh - g; ++ly) {
+          const ubyte *mid = m_tileData.data() + ly * pitch + g - 1;
+          m_haloRowKernel(mid - pitch, mid, mid + pitch,
+                          m_tileResultData.data() + ly * pitch + g - 1,
+                          lw - 2 * g);
+        }
+        std::swap(m_tileData, m_tileResultData);
+      }
+
+      for (size_t ly = 0; ly < th; ++ly)
+        std::memcpy(m_resultData + (ty + ly) * m_worldWidth + tx,
+                    m_tileData.data() + (ly + k) * pitch + k, tw);
+    }
+  }
+  std::swap(m_data, m_resultData);
+}
+
+void prepareActive() {
+  m_activeTilesX = (m_worldWidth + activeTileSize - 1) / activeTileSize;
+  m_activeTilesY = (m_worldHeight + activeTileSize - 1) / activeTileSize;
+  size_t tiles = m_activeTilesX * m_activeTilesY;
+  m_tileChanged1.assign(tiles, 1);
+  m_tileChanged2.assign(tiles, 1);
+  m_nextTileChanged1.assign(tiles, 1);
+  m_nextTileChanged2.assign(tiles, 1);
+
+  // The result buffer holds no history yet, and the first comparison against
+  // it is meaningless, so the first two generations compute everything.
+  m_activeWarmup = 2;
+}
+
+void computeActiveTile(size_t tx, size_t ty, ubyte &changed1,
+                       ubyte &changed2) {
+  size_t yEnd = std::min(m_worldHeight, (ty + 1) * activeTileSize);
+  size_t xEnd = std::min(m_worldWidth, (tx + 1) * activeTileSize);
+  const Rule rule = m_rule;
+  changed1 = changed2 = 0;
+
+  for (size_t y = ty * activeTileSize; y < yEnd; ++y) {
+    size_t y0 = ((y + m_worldHeight - 1) % m_worldHeight) * m_worldWidth;
+    size_t y1 = y * m_worldWidth;
+    size_t y2 = ((y + 1) % m_worldHeight) * m_worldWidth;
+
+    for (size_t x = tx * activeTileSize; x < xEnd; ++x) {
+      size_t x0 = (x + m_worldWidth - 1) % m_worldWidth;
+      size_t x2 = (x + 1) % m_worldWidth;
+
+      ubyte aliveCells = countAliveCells(x0, x, x2, y0, y1, y2);
+      ubyte cell = nextState(rule, aliveCells, m_data[x + y1]);
+      changed1 |= cell ^ m_data[x + y1];
+      changed2 |= cell ^ m_resultData[x + y1];
+      m_resultData[x + y1] = cell;
+    }
+  }
+}
+
+void computeIterationActive() {
+  m_activeSkipped = 0;
+  for (size_t ty = 0; ty < m_activeTilesY; ++ty) {
+    for (size_t tx = 0; tx < m_activeTilesX; ++tx) {
+      size_t tile = ty * m_activeTilesX + tx;
+      bool still1 = m_activeWarmup == 0;
+      bool still2 = m_activeWarmup == 0;
+      for (size_t dy = 0; dy < 3 && (still1 || still2); ++dy) {
+        size_t ny = (ty + m_activeTilesY + dy - 1) % m_activeTilesY;
+        for (size_t dx = 0; dx < 3; ++dx) {
+          size_t nx = (tx + m_activeTilesX + dx - 1) % m_activeTilesX;
+          still1 &= !m_tileChanged1[ny * m_activeTilesX + nx];
+          still2 &= !m_tileChanged2[ny * m_activeTilesX + nx];
+        }
+      }
+
+      if (still1) {
+        // t + 1 == t == t - 1
+        m_nextTileChanged1[tile] = m_nextTileChanged2[tile] = 0;
+        ++m_activeSkipped;
+      } else if (still2) {
+        // t + 1 == t - 1, so it differs from t exactly when t did
+        m_nextTileChanged1[tile] = m_tileChanged1[tile];
+        m_nextTileChanged2[tile] = 0;
+        ++m_activeSkipped;
+      } else {
+        computeActiveTile(tx, ty, m_nextTileChanged1[tile],
+                          m_nextTileChanged2[tile]);
+      }
+    }
+  }
+
+  if (m_activeWarmup > 0)
+    --m_activeWarmup;
+  std::swap(m_tileChanged1, m_nextTileChanged1);
+  std::swap(m_tileChanged2, m_nextTileChanged2);
+  std::swap(m_data, m_resultData);
+}
+
+void loadHashlife() { m_hashlife.load(m_data, m_worldWidth, m_worldHeight); }
+
+void storeHashlife() { m_hashlife.store(m_data); }
+
+void computeIterationHashlife() { m_hashlife.step(m_hashlifeStep); }
+
 void computeIterationSerialIfs() {
   for (size_t y = 0; y < m_worldHeight; ++y) {
     size_t y0 = ((y + m_worldHeight - 1) % m_worldHeight) * m_worldWidth;
@@ -94,14 +809,30 @@ void computeIterationSerialIfs() {
       size_t x2 = (x + 1) % m_worldWidth;
 
       ubyte aliveCells = countAliveCellsIfs(x0, x, x2, y0, y1, y2);
-      m_resultData[y1 + x] =
-          aliveCells == 3 || (aliveCells == 2 && m_data[x + y1]) ? 1 : 0;
+      m_resultData[y1 + x] = nextState(m_rule, aliveCells, m_data[x + y1]);
     }
   }
   std::swap(m_data, m_resultData);
 }
 
 void computeIterationSerial2D() {
+  const Rule rule = m_rule;
+  const ptrdiff_t width = m_worldWidth, height = m_worldHeight;
+  m_grid.wrapHalo();
+  for (ptrdiff_t y = 0; y < height; ++y) {
+    RowSpan up = m_grid.row(y - 1), mid = m_grid.row(y),
+            down = m_grid.row(y + 1), result = m_gridResult.row(y);
+
+    for (ptrdiff_t x = 0; x < width; ++x) {
+      ubyte alive = up[x - 1] + up[x] + up[x + 1] + mid[x - 1] + mid[x + 1] +
+                    down[x - 1] + down[x] + down[x + 1];
+      result[x] = nextState(rule, alive, mid[x]);
+    }
+  }
+  m_grid.swap(m_gridResult);
+}
+
+void computeIterationSerialRows2D() {
   for (size_t y = 0; y < m_worldHeight; ++y) {
     size_t y0 = (y + m_worldHeight - 1) % m_worldHeight;
     size_t y2 = (y + m_worldHeight + 1) % m_worldHeight;
@@ -111,8 +842,7 @@ void computeIterationSerial2D() {
       size_t x2 = (x + m_worldWidth + 1) % m_worldWidth;
 
       ubyte alive = countAliveCells2D(x0, x, x2, y0, y, y2);
-      m_resultData2D[y][x] =
-          (alive == 3 || (alive == 2 && m_data2D[y][x])) ? 1 : 0;
+      m_resultData2D[y][x] = nextState(m_rule, alive, m_data2D[y][x]);
     }
   }
   std::swap(m_data2D, m_resultData2D);
@@ -121,87 +851,1025 @@ void computeIterationSerial2D() {
 void cleanup() {
   delete[] m_data;
   delete[] m_resultData;
+  m_data = nullptr;
+  m_resultData = nullptr;
 
-  for (size_t y = 0; y < m_worldHeight; ++y) {
+  for (size_t y = 0; m_data2D && y < m_worldHeight; ++y) {
     delete[] m_data2D[y];
     delete[] m_resultData2D[y];
   }
 
   delete[] m_data2D;
   delete[] m_resultData2D;
+  m_data2D = nullptr;
+  m_resultData2D = nullptr;
+
+  delete[] m_bitData;
+  delete[] m_bitResultData;
+  m_bitData = nullptr;
+  m_bitResultData = nullptr;
+
+  delete[] m_blockData;
+  delete[] m_blockResultData;
+  m_blockData = nullptr;
+  m_blockResultData = nullptr;
+
+  m_grid = Grid();
+  m_gridResult = Grid();
 }
 
-void runExperiment(ubyte iterations, void (*func)(void), std::ofstream &outfile,
-                   std::string title) {
-  randomizeWorld();
-  std::vector<double> timings;
+// Runs the same world through computeIterationSerial and `func` and checks
+// that both end up in the same state after `iterations` generations, rounded
+// up to whole calls when `func` advances several generations per call.
+bool matchesSerial(size_t iterations, void (*func)(void),
+                   void (*prepare)(void), void (*finish)(void),
+                   size_t generationsPerCall = 1) {
+  size_t calls = (iterations + generationsPerCall - 1) / generationsPerCall;
+  m_seedWorld();
+  std::vector<ubyte> initial(m_data, m_data + m_dataLength);
 
-  for (int i = 0; i < 5; ++i) {
-    auto start = std::chrono::high_resolution_clock::now();
-    for (int j = 0; j < iterations; ++j)
-      func();
-    auto end = std::chrono::high_resolution_clock::now();
+  for (size_t j = 0; j < calls * generationsPerCall; ++j)
+    computeIterationSerial();
+  std::vector<ubyte> expected(m_data, m_data + m_dataLength);
 
-    double timePerIteration =
-        std::chrono::duration<double>(end - start).count() / iterations;
-    timings.push_back(timePerIteration);
-  }
+  std::copy(initial.begin(), initial.end(), m_data);
+  if (prepare)
+    prepare();
+  for (size_t j = 0; j < calls; ++j)
+    func();
+  if (finish)
+    finish();
+
+  return std::equal(expected.begin(), expected.end(), m_data);
+}
+
+// The world is seeded once and keeps evolving through the warmup and every
+// repetition, as a long running simulation would.
+void runExperiment(size_t iterations, void (*func)(void), BenchReport &report,
+                   std::string title, void (*prepare)(void) = nullptr,
+                   size_t generationsPerCall = 1) {
+  size_t calls = (iterations + generationsPerCall - 1) / generationsPerCall;
+  iterations = calls * generationsPerCall;
 
-  std::sort(timings.begin(), timings.end());
-  double medianTime = timings[timings.size() / 2];
+  m_seedWorld();
+  if (prepare)
+    prepare();
 
-  int cellsPerSecond = std::round(m_dataLength / medianTime);
+  BenchSamples samples = measure(m_bench, iterations, [] {}, [&] {
+    for (size_t j = 0; j < calls; ++j)
+      func();
+  });
 
-  outfile << title << ',' << m_worldWidth << ',' << m_worldHeight << ','
-          << m_dataLength << ',' << (uint)iterations << ',' << medianTime << ','
-          << cellsPerSecond << '\n';
+  unsigned threads = m_pool ? m_pool->size() : 1;
+  report.add(title, m_worldWidth, m_worldHeight, threads, iterations, samples);
 }
 
-void experiment(ubyte iterations, int height, int width,
-                std::ofstream &outfile) {
+void allocateWorld(size_t height, size_t width) {
   m_worldHeight = height;
   m_worldWidth = width;
   m_dataLength = m_worldHeight * m_worldWidth;
 
   m_data = new ubyte[m_dataLength];
   m_resultData = new ubyte[m_dataLength];
+}
 
-  // Serial case
-  runExperiment(iterations, computeIterationSerial, outfile, "Serial");
+// Registry adapters. Every serial engine works on the m_ globals, so only
+// one of them holds a world at a time and load() rebuilds whatever buffers
+// the previous engine left behind.
+void allocateEngineWorld(size_t height, size_t width) {
+  if (m_data && m_worldHeight == height && m_worldWidth == width)
+    return;
+  cleanup();
+  allocateWorld(height, width);
 
-  // Ifs case
-  runExperiment(iterations, computeIterationSerialIfs, outfile, "Serial Ifs");
+  if (m_worldWidth % 64 == 0) {
+    m_wordsPerRow = m_worldWidth / 64;
+    m_bitData = new uint64_t[m_wordsPerRow * m_worldHeight];
+    m_bitResultData = new uint64_t[m_wordsPerRow * m_worldHeight];
+  }
+
+  if (m_worldWidth % 2 == 0 && m_worldHeight % 2 == 0) {
+    m_blocksPerRow = m_worldWidth / 2;
+    m_blockRows = m_worldHeight / 2;
+    m_blockData = new ubyte[m_blocksPerRow * m_blockRows];
+    m_blockResultData = new ubyte[m_blocksPerRow * m_blockRows];
+  }
+
+  m_grid = Grid(m_worldWidth, m_worldHeight);
+  m_gridResult = Grid(m_worldWidth, m_worldHeight);
 
-  // 2D case
   m_data2D = new ubyte *[m_worldHeight];
   m_resultData2D = new ubyte *[m_worldHeight];
   for (size_t y = 0; y < m_worldHeight; ++y) {
     m_data2D[y] = new ubyte[m_worldWidth];
     m_resultData2D[y] = new ubyte[m_worldWidth];
   }
-  runExperiment(iterations, computeIterationSerial2D, outfile, "Serial 2D");
+}
+
+class SerialEngine : public LifeEngine {
+public:
+  SerialEngine(const char *title, void (*func)(void), void (*prepare)(void),
+               void (*finish)(void), unsigned workers = 0)
+      : title(title), func(func), prepare(prepare), finish(finish) {
+    if (workers > 0)
+      pool.reset(new BandPool(workers));
+  }
+
+  std::string name() const override { return title; }
+
+  void load(const ubyte *data, size_t width, size_t height) override {
+    if (func == computeIterationSerialBitboard && width % 64 != 0)
+      throw std::logic_error("[Engine] Serial Bitpacked needs a width "
+                             "multiple of 64.");
+    if (func == computeIterationSerialBlock && (width % 2 || height % 2))
+      throw std::logic_error("[Engine] Serial Block needs an even width "
+                             "and height.");
+    allocateEngineWorld(height, width);
+    std::copy(data, data + m_dataLength, m_data);
+    if (prepare)
+      prepare();
+  }
+
+  void step(size_t generations) override {
+    m_pool = pool.get();
+    for (size_t i = 0; i < generations; ++i)
+      func();
+    m_pool = nullptr;
+  }
+
+  void readback(ubyte *data) override {
+    if (finish)
+      finish();
+    std::copy(m_data, m_data + m_dataLength, data);
+  }
+
+  unsigned threads() const override { return pool ? pool->size() : 1; }
+
+protected:
+  std::string title;
+  void (*func)(void);
+  void (*prepare)(void);
+  void (*finish)(void);
+  std::unique_ptr<BandPool> pool;
+};
+
+// Temporal blocking and Hashlife advance several generations per call
+class SerialTemporalEngine : public SerialEngine {
+public:
+  SerialTemporalEngine(unsigned steps)
+      : SerialEngine("Serial Temporal", computeIterationSerialTemporal,
+                     nullptr, nullptr),
+        steps(steps ? steps : 8) {}
+
+  void step(size_t generations) override {
+    for (size_t done = 0; done < generations; done += m_temporalSteps) {
+      m_temporalSteps = std::min<size_t>(steps, generations - done);
+      func();
+    }
+  }
+
+private:
+  size_t steps;
+};
+
+class HashlifeEngine : public SerialEngine {
+public:
+  HashlifeEngine()
+      : SerialEngine("Hashlife", computeIterationHashlife, loadHashlife,
+                     storeHashlife) {}
+
+  void step(size_t generations) override {
+    for (unsigned bit = 0; generations >> bit; ++bit)
+      if (generations >> bit & 1)
+        m_hashlife.step(bit);
+  }
+};
+
+// Strips in forked worker processes, see cluster.h. The workers keep the
+// rule and SIMD row kernel selected when the world is first loaded.
+class ProcessEngine : public LifeEngine {
+public:
+  explicit ProcessEngine(unsigned processes) : processes(processes) {}
+
+  std::string name() const override { return "Serial Processes"; }
+
+  void load(const ubyte *data, size_t width, size_t height) override {
+    if (!cluster || width != worldWidth || height != worldHeight) {
+      cluster.reset();
+      cluster.reset(
+          new ProcessCluster(width, height, processes, m_haloRowKernel));
+      worldWidth = width;
+      worldHeight = height;
+    }
+    cluster->load(data);
+  }
+
+  void step(size_t generations) override { cluster->step(generations); }
+
+  void readback(ubyte *data) override { cluster->store(data); }
+
+  unsigned threads() const override { return processes; }
+
+private:
+  unsigned processes;
+  size_t worldWidth = 0;
+  size_t worldHeight = 0;
+  std::unique_ptr<ProcessCluster> cluster;
+};
+
+const bool serialEnginesRegistered = [] {
+  registerEngine("serial", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial", computeIterationSerial, nullptr, nullptr));
+  });
+  registerEngine("serial-ifs", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial Ifs", computeIterationSerialIfs, nullptr, nullptr));
+  });
+  registerEngine("serial-2d", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial 2D", computeIterationSerial2D, loadGrid, storeGrid));
+  });
+  registerEngine("serial-2d-rows", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(
+        new SerialEngine("Serial 2D Rows", computeIterationSerialRows2D,
+                         loadRows2D, storeRows2D));
+  });
+  registerEngine("serial-threads", [](const EngineOptions &options) {
+    unsigned workers = options.threads ? options.threads : m_threadCount;
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial Threads", computeIterationParallel, nullptr, nullptr, workers));
+  });
+  registerEngine("serial-bitpacked", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(
+        new SerialEngine("Serial Bitpacked", computeIterationSerialBitboard,
+                         packWorld, unpackWorld));
+  });
+  registerEngine("serial-block", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(
+        new SerialEngine("Serial Block", computeIterationSerialBlock,
+                         packBlocks, unpackBlocks));
+  });
+  registerEngine("serial-simd", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial SIMD", computeIterationSerialSimd, loadGrid, storeGrid));
+  });
+  registerEngine("serial-active", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new SerialEngine(
+        "Serial Active", computeIterationActive, prepareActive, nullptr));
+  });
+  registerEngine("serial-temporal", [](const EngineOptions &options) {
+    return std::unique_ptr<LifeEngine>(
+        new SerialTemporalEngine(options.steps));
+  });
+  registerEngine("hashlife", [](const EngineOptions &) {
+    return std::unique_ptr<LifeEngine>(new HashlifeEngine());
+  });
+  registerEngine("serial-processes", [](const EngineOptions &options) {
+    unsigned processes = options.threads ? options.threads : m_threadCount;
+    return std::unique_ptr<LifeEngine>(new ProcessEngine(processes));
+  });
+  return true;
+}();
+
+void experiment(size_t iterations, size_t height, size_t width,
+                BenchReport &report) {
+  allocateWorld(height, width);
+
+  // Serial case
+  if (benchSelected(m_bench, "plain"))
+    runExperiment(iterations, computeIterationSerial, report, "Serial");
+
+  // Temporal blocking, k generations per tile visit
+  for (size_t k = 1; k <= 8 && benchSelected(m_bench, "temporal"); ++k) {
+    m_temporalSteps = k;
+    std::string title = "Serial Temporal k=" + std::to_string(k);
+    if (!matchesSerial(iterations, computeIterationSerialTemporal, nullptr,
+                       nullptr, k))
+      std::cerr << title << " does not match Serial\n";
+    runExperiment(iterations, computeIterationSerialTemporal, report, title,
+                  nullptr, k);
+  }
+
+  // Ifs case
+  if (benchSelected(m_bench, "ifs"))
+    runExperiment(iterations, computeIterationSerialIfs, report, "Serial Ifs");
+
+  // Active region case
+  if (benchSelected(m_bench, "active")) {
+    if (!matchesSerial(iterations, computeIterationActive, prepareActive,
+                       nullptr))
+      std::cerr << "Serial Active does not match Serial\n";
+    runExperiment(iterations, computeIterationActive, report, "Serial Active",
+                  prepareActive);
+  }
+
+  // Threaded case
+  if (benchSelected(m_bench, "threads")) {
+    BandPool pool(m_threadCount);
+    m_pool = &pool;
+    if (!matchesSerial(iterations, computeIterationParallel, nullptr, nullptr))
+      std::cerr << "Serial Threads does not match Serial\n";
+    runExperiment(iterations, computeIterationParallel, report,
+                  "Serial Threads");
+    m_pool = nullptr;
+  }
+
+  // Bit-packed case, rows must fill whole words
+  if (benchSelected(m_bench, "bitpacked") && m_worldWidth % 64 == 0) {
+    m_wordsPerRow = m_worldWidth / 64;
+    m_bitData = new uint64_t[m_wordsPerRow * m_worldHeight];
+    m_bitResultData = new uint64_t[m_wordsPerRow * m_worldHeight];
+
+    if (!matchesSerial(iterations, computeIterationSerialBitboard, packWorld,
+                       unpackWorld))
+      std::cerr << "Serial Bitpacked does not match Serial\n";
+    runExperiment(iterations, computeIterationSerialBitboard, report,
+                  "Serial Bitpacked", packWorld);
+  }
+
+  // 2x2 block lookup case, blocks must tile the world
+  if (benchSelected(m_bench, "block") && m_worldWidth % 2 == 0 &&
+      m_worldHeight % 2 == 0) {
+    m_blocksPerRow = m_worldWidth / 2;
+    m_blockRows = m_worldHeight / 2;
+    m_blockData = new ubyte[m_blocksPerRow * m_blockRows];
+    m_blockResultData = new ubyte[m_blocksPerRow * m_blockRows];
+
+    if (!matchesSerial(iterations, computeIterationSerialBlock, packBlocks,
+                       unpackBlocks))
+      std::cerr << "Serial Block does not match Serial\n";
+    runExperiment(iterations, computeIterationSerialBlock, report,
+                  "Serial Block", packBlocks);
+  }
+
+  // SIMD and 2D cases over the pitched grid
+  if (benchSelected(m_bench, "simd") || benchSelected(m_bench, "2d")) {
+    m_grid = Grid(m_worldWidth, m_worldHeight);
+    m_gridResult = Grid(m_worldWidth, m_worldHeight);
+  }
+
+  if (benchSelected(m_bench, "simd")) {
+    if (!matchesSerial(iterations, computeIterationSerialSimd, loadGrid,
+                       storeGrid))
+      std::cerr << "Serial SIMD does not match Serial\n";
+    runExperiment(iterations, computeIterationSerialSimd, report,
+                  "Serial SIMD", loadGrid);
+  }
+
+  // 2D case, row pointers against the pitched grid
+  if (benchSelected(m_bench, "2d")) {
+    m_data2D = new ubyte *[m_worldHeight];
+    m_resultData2D = new ubyte *[m_worldHeight];
+    for (size_t y = 0; y < m_worldHeight; ++y) {
+      m_data2D[y] = new ubyte[m_worldWidth];
+      m_resultData2D[y] = new ubyte[m_worldWidth];
+    }
+    if (!matchesSerial(iterations, computeIterationSerialRows2D, loadRows2D,
+                       storeRows2D))
+      std::cerr << "Serial 2D Rows does not match Serial\n";
+    runExperiment(iterations, computeIterationSerialRows2D, report,
+                  "Serial 2D Rows", loadRows2D);
+
+    if (!matchesSerial(iterations, computeIterationSerial2D, loadGrid,
+                       storeGrid))
+      std::cerr << "Serial 2D does not match Serial\n";
+    runExperiment(iterations, computeIterationSerial2D, report, "Serial 2D",
+                  loadGrid);
+  }
 
   cleanup();
 }
 
-int main() {
+// Strong scaling keeps the world fixed while adding threads, weak scaling
+// grows the world with the thread count so each thread keeps 2^22 cells.
+void scalingExperiment(size_t iterations, BenchReport &report) {
+  std::vector<unsigned> threadCounts;
+  for (unsigned threads = 1; threads < m_threadCount; threads *= 2)
+    threadCounts.push_back(threads);
+  threadCounts.push_back(m_threadCount);
+
+  size_t worldWidth = 1ull << 15;
+  for (unsigned threads : threadCounts) {
+    std::cout << "Escalamiento con " << threads << " hebras\n";
+    BandPool pool(threads);
+    m_pool = &pool;
+
+    allocateWorld(1ull << 10, worldWidth);
+    runExperiment(iterations, computeIterationParallel, report,
+                  "Serial Threads Strong");
+    delete[] m_data;
+    delete[] m_resultData;
+
+    allocateWorld((1ull << 7) * threads, worldWidth);
+    runExperiment(iterations, computeIterationParallel, report,
+                  "Serial Threads Weak");
+    delete[] m_data;
+    delete[] m_resultData;
+
+    m_pool = nullptr;
+  }
+}
+
+// Median seconds per generation of `processes` workers on the current world
+double runProcessExperiment(size_t iterations, BenchReport &report,
+                            const std::string &title, unsigned processes) {
+  ProcessCluster cluster(m_worldWidth, m_worldHeight, processes,
+                         m_haloRowKernel);
+  m_seedWorld();
+  cluster.load(m_data);
+
+  BenchSamples samples = measure(m_bench, iterations, [] {},
+                                 [&] { cluster.step(iterations); });
+  report.add(title, m_worldWidth, m_worldHeight, processes, iterations,
+             samples);
+  return computeStats(samples.seconds).median;
+}
+
+// The same strong and weak scaling as scalingExperiment, with worker
+// processes exchanging halo rows instead of threads sharing the world.
+// Efficiency is the speedup over one process divided by the process count
+// (strong), or the time of one process over the time of n (weak).
+void processScalingExperiment(size_t iterations, BenchReport &report) {
+  std::vector<unsigned> processCounts;
+  for (unsigned processes = 1; processes < m_threadCount; processes *= 2)
+    processCounts.push_back(processes);
+  processCounts.push_back(m_threadCount);
+
+  size_t worldWidth = 1ull << 15;
+  double strongBase = 0, weakBase = 0;
+  for (unsigned processes : processCounts) {
+    allocateWorld(1ull << 10, worldWidth);
+    double strong = runProcessExperiment(iterations, report,
+                                         "Serial Processes Strong", processes);
+    delete[] m_data;
+    delete[] m_resultData;
+
+    allocateWorld((1ull << 7) * processes, worldWidth);
+    double weak = runProcessExperiment(iterations, report,
+                                       "Serial Processes Weak", processes);
+    delete[] m_data;
+    delete[] m_resultData;
+
+    if (processes == 1) {
+      strongBase = strong;
+      weakBase = weak;
+    }
+    std::cout << "Escalamiento con " << processes
+              << " procesos, eficiencia fuerte "
+              << 100 * strongBase / (processes * strong) << "%, débil "
+              << 100 * weakBase / weak << "%\n";
+  }
+}
+
+// Hashlife only pays off on worlds with repeated structure, so it is compared
+// against the plain serial sweep on periodic and structured seeds.
+void hashlifeExperiment(BenchReport &report) {
+  struct Seed {
+    const char *name;
+    void (*seed)(void);
+  };
+  const Seed seeds[] = {{"Periodic", seedPeriodicWorld},
+                        {"Structured", seedStructuredWorld}};
+
+  allocateWorld(1ull << 10, 1ull << 15);
+  for (const Seed &seed : seeds) {
+    std::cout << "Hashlife " << seed.name << '\n';
+    m_seedWorld = seed.seed;
+    runExperiment(m_bench.iterations, computeIterationSerial, report,
+                  std::string("Serial ") + seed.name);
+
+    m_hashlifeStep = 4;
+    if (!matchesSerial(16, computeIterationHashlife, loadHashlife,
+                       storeHashlife, 16))
+      std::cerr << "Hashlife " << seed.name << " does not match Serial\n";
+
+    m_hashlifeStep = 10;
+    runExperiment(1024, computeIterationHashlife, report,
+                  std::string("Hashlife ") + seed.name, loadHashlife, 1024);
+  }
+  m_seedWorld = randomizeWorld;
+
+  delete[] m_data;
+  delete[] m_resultData;
+}
+
+// Follows a random world as it settles, logging the share of skipped tiles and
+// the throughput of every generation.
+void activeRegionExperiment(size_t generations) {
+  std::ofstream outfile("active_benchmark.csv");
+  outfile << "Generation,Skipped,Time[s],Cells/s\n";
+
+  allocateWorld(1ull << 10, 1ull << 12);
+  randomizeWorld();
+  prepareActive();
+  double tiles = m_activeTilesX * m_activeTilesY;
+
+  std::cout << "Regiones activas, " << generations << " generaciones\n";
+  for (size_t generation = 1; generation <= generations; ++generation) {
+    auto start = std::chrono::high_resolution_clock::now();
+    computeIterationActive();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double time = std::chrono::duration<double>(end - start).count();
+    outfile << generation << ',' << m_activeSkipped / tiles << ',' << time
+            << ',' << std::llround(m_dataLength / time) << '\n';
+  }
+
+  delete[] m_data;
+  delete[] m_resultData;
+}
+
+// Plain simulation run instead of the benchmark. The world comes from the
+// seed function or from a snapshot, uses the bit-packed engine when the width
+// allows it and can be checkpointed along the way.
+void reportCycle(const CycleWatch &watch, const CycleOptions &cycle) {
+  if (!watch.enabled())
+    return;
+  if (watch.found())
+    std::cout << "Ciclo de periodo " << watch.period << ": la generación "
+              << watch.firstRepeat << " repite la "
+              << watch.firstRepeat - watch.period
+              << (cycle.verify ? " (verificado)" : "") << '\n';
+  else
+    std::cout << "Sin ciclos de periodo hasta " << cycle.maxPeriod << '\n';
+  if (watch.collisions)
+    std::cout << "Coincidencias de hash descartadas: " << watch.collisions
+              << '\n';
+}
+
+void simulate(size_t height, size_t width, size_t generations,
+              const std::string &restorePath,
+              const std::string &checkpointPath, size_t checkpointEvery,
+              const std::string &rlePath, const CycleOptions &cycle,
+              const std::string &statsPath, StatsFormat statsFormat) {
+  std::unique_ptr<Snapshot> snapshot;
+  uint64_t generation = 0;
+  if (!restorePath.empty()) {
+    snapshot.reset(new Snapshot(restorePath));
+    height = snapshot->height();
+    width = snapshot->width();
+    generation = snapshot->generation();
+  }
+
+  allocateWorld(height, width);
+  bool packed = m_worldWidth % 64 == 0;
+  if (packed) {
+    m_wordsPerRow = m_worldWidth / 64;
+    m_bitData = new uint64_t[m_wordsPerRow * m_worldHeight];
+    m_bitResultData = new uint64_t[m_wordsPerRow * m_worldHeight];
+  }
+
+  if (snapshot && packed) {
+    // Same layout, the first generation reads its rows from the mapping
+    m_bitSource = snapshot->row(0);
+  } else {
+    if (snapshot)
+      snapshot->unpack(m_data);
+    else
+      m_seedWorld();
+    if (packed)
+      packWorld();
+    snapshot.reset();
+  }
+
+  // The packed engines only need the cells for the first hash and stats
+  // and to verify a cycle
+  CycleWatch watch(cycle);
+  std::unique_ptr<StatsTally> stats;
+  std::unique_ptr<StatsSink> sink;
+  if (packed && (watch.enabled() || !statsPath.empty())) {
+    if (m_bitSource)
+      snapshot->unpack(m_data);
+    else
+      unpackWorld();
+  }
+  uint64_t hash = watch.enabled() ? worldHash(m_data, m_dataLength) : 0;
+  watch.observe(generation, hash); // A still life repeats it right away
+  if (!statsPath.empty()) {
+    sink.reset(new StatsSink(statsPath, statsFormat, m_worldWidth,
+                             m_worldHeight));
+    stats.reset(new StatsTally(m_worldWidth, m_worldHeight));
+    stats->countWorld(m_data);
+    sink->push(stats->stats(generation));
+  }
+  m_hashChanges = watch.enabled();
+  m_stats = stats.get();
+
+  auto checkpoint = [&]() {
+    if (packed)
+      writeSnapshotPacked(checkpointPath, m_bitData, m_worldWidth,
+                          m_worldHeight, generation);
+    else
+      writeSnapshot(checkpointPath, m_data, m_worldWidth, m_worldHeight,
+                    generation);
+  };
+
+  for (size_t i = 0; i < generations && !watch.found(); ++i) {
+    if (packed)
+      computeIterationSerialBitboard();
+    else if (watch.enabled() || m_stats)
+      computeIterationSerialTallied();
+    else
+      computeIterationSerial();
+    ++generation;
+    snapshot.reset(); // Only the first generation reads the mapping
+    if (m_stats)
+      sink->push(m_stats->stats(generation));
+
+    if (watch.enabled()) {
+      hash ^= m_changesHash;
+      watch.observe(generation, hash);
+      if (watch.wantsWorld() == generation) {
+        if (packed)
+          unpackWorld();
+        watch.offer(generation, m_data, m_dataLength);
+      }
+    }
+
+    if (!checkpointPath.empty() && checkpointEvery &&
+        generation % checkpointEvery == 0)
+      checkpoint();
+  }
+  m_hashChanges = false;
+  m_stats = nullptr;
+  if (m_bitSource) {
+    // No generation ran, the world is still only in the mapping
+    std::memcpy(m_bitData, m_bitSource,
+                m_wordsPerRow * m_worldHeight * sizeof(uint64_t));
+    m_bitSource = nullptr;
+  }
+  snapshot.reset();
+  if (sink)
+    sink->close();
+  if (!checkpointPath.empty())
+    checkpoint();
+
+  if (packed)
+    unpackWorld();
+  if (!rlePath.empty()) {
+    std::ofstream out(rlePath);
+    writeRle(out, m_data, m_worldWidth, m_worldHeight, m_rule);
+  }
+  std::cout << "Generación " << generation << '\n';
+  reportCycle(watch, cycle);
+
+  delete[] m_data;
+  delete[] m_resultData;
+  delete[] m_bitData;
+  delete[] m_bitResultData;
+  m_bitData = nullptr;
+  m_bitResultData = nullptr;
+}
+
+// --simulate through a registry engine, so the OpenCL and CUDA drivers can
+// run long simulations too. Engines that fold the world hash into their
+// update are stepped in batches and only read back to verify a cycle or to
+// checkpoint; the others are diffed on the host after every generation.
+void simulateEngine(const std::string &key, const EngineOptions &options,
+                    size_t height, size_t width, size_t generations,
+                    const std::string &restorePath,
+                    const std::string &checkpointPath, size_t checkpointEvery,
+                    const std::string &rlePath, const CycleOptions &cycle) {
+  std::unique_ptr<Snapshot> snapshot;
+  uint64_t generation = 0;
+  if (!restorePath.empty()) {
+    snapshot.reset(new Snapshot(restorePath));
+    height = snapshot->height();
+    width = snapshot->width();
+    generation = snapshot->generation();
+  }
+
+  // The serial engines own the m_ globals once loaded
+  allocateWorld(height, width);
+  if (snapshot)
+    snapshot->unpack(m_data);
+  else
+    m_seedWorld();
+  snapshot.reset();
+  std::vector<ubyte> world(m_data, m_data + m_dataLength);
+  std::vector<ubyte> next(world.size());
+  cleanup();
+
+  std::unique_ptr<LifeEngine> engine = createEngine(key, options);
+  engine->load(world.data(), width, height);
+
+  CycleWatch watch(cycle);
+  uint64_t hash = watch.enabled() ? worldHash(world.data(), world.size()) : 0;
+  watch.observe(generation, hash);
+  const size_t batch = 64;
+  std::vector<uint64_t> changes(batch);
+  bool fused = true;
+
+  uint64_t last = generation + generations;
+  while (generation < last && !watch.found()) {
+    size_t count = last - generation;
+    if (watch.enabled())
+      count = std::min(count, batch);
+    if (checkpointEvery)
+      count = std::min(count, checkpointEvery - generation % checkpointEvery);
+    if (watch.wantsWorld() > generation)
+      count = std::min<size_t>(count, watch.wantsWorld() - generation);
+
+    if (!watch.enabled()) {
+      engine->step(count);
+    } else if (!fused || !engine->stepHashed(count, changes.data())) {
+      // `world` follows the engine one generation at a time
+      fused = false;
+      count = 1;
+      engine->step(1);
+      engine->readback(next.data());
+      changes[0] = 0;
+      for (size_t i = 0; i < world.size(); ++i)
+        if (world[i] != next[i])
+          changes[0] ^= cellKey(i);
+      world.swap(next);
+    }
+
+    for (size_t g = 0; watch.enabled() && g < count; ++g) {
+      hash ^= changes[g];
+      watch.observe(generation + g + 1, hash);
+    }
+    generation += count;
+
+    if (watch.wantsWorld() && watch.wantsWorld() <= generation) {
+      engine->readback(world.data());
+      watch.offer(generation, world.data(), world.size());
+    }
+    if (!checkpointPath.empty() && checkpointEvery &&
+        generation % checkpointEvery == 0) {
+      engine->readback(world.data());
+      writeSnapshot(checkpointPath, world.data(), width, height, generation);
+    }
+  }
+
+  engine->readback(world.data());
+  std::cout << engine->name() << ", generación " << generation << '\n';
+  reportCycle(watch, cycle);
+  engine.reset();
+  cleanup();
+
+  if (!checkpointPath.empty())
+    writeSnapshot(checkpointPath, world.data(), width, height, generation);
+  if (!rlePath.empty()) {
+    std::ofstream out(rlePath);
+    writeRle(out, world.data(), width, height, m_rule);
+  }
+}
+
+// Runs engines from the registry by name instead of the serial experiments,
+// optionally checking each one against the plain serial engine first.
+int backendExperiment(const std::vector<std::string> &keys,
+                      std::vector<unsigned> threadOptions,
+                      const EngineOptions &options, bool check) {
+  std::vector<std::string> known = engineNames();
+  BenchOptions listed = m_bench;
+  listed.engines = keys;
+  if (!checkEngines(listed, known))
+    return 1;
+
+#ifdef BACKEND
+  if (threadOptions.empty())
+    threadOptions = {64, 128, 256, 512, 1024};
+  if (m_bench.sizes.empty())
+    parseSizes("2^15x2^1-15", m_bench.sizes);
+  BenchReport report(m_bench, BACKEND "_benchmark", "μs", 1e6);
+#else
+  if (threadOptions.empty())
+    threadOptions = {m_threadCount};
+  if (m_bench.sizes.empty())
+    parseSizes("2^15x2^1-10", m_bench.sizes);
+  BenchReport report(m_bench, "engine_benchmark");
+#endif
+  report.meta("rule", ruleString(options.rule));
+
+  try {
+    benchmarkEngines(keys, threadOptions, options, m_bench, report,
+                     check ? "serial" : "");
+    report.save();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  cleanup();
+  std::cout << "Resultados en " << report.outputPath() << '\n';
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
   srand(static_cast<unsigned>(time(nullptr)));
+  const char *haloKernel = selectHaloRowKernel();
+
+  size_t simulateGenerations = 0;
+  size_t simulateWidth = 1ull << 10, simulateHeight = 1ull << 10;
+  size_t checkpointEvery = 0;
+  std::string restorePath, checkpointPath, rlePath, streamPath, statsPath;
+  StatsFormat statsFormat = StatsFormat::csv;
+  std::vector<std::string> backends;
+  std::vector<unsigned> threadOptions;
+  EngineOptions engineOptions;
+  CycleOptions cycle;
+  bool check = false;
+#ifdef BACKEND
+  m_bench.repetitions = 15;
+#endif
 
-  std::ofstream outfile("serial_benchmark.csv");
-  if (!outfile) {
-    std::cerr << "Failed to open serial_results.csv for writing.\n";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      m_threadCount = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--rule" && i + 1 < argc) {
+      Rule rule;
+      if (!parseRule(argv[++i], rule)) {
+        std::cerr << "Invalid rule " << argv[i] << '\n';
+        return 1;
+      }
+      selectRule(rule);
+    } else if (arg == "--hashlife-memory" && i + 1 < argc) {
+      m_hashlife.setMemoryLimit(std::strtoull(argv[++i], nullptr, 10) << 20);
+    } else if (arg == "--pattern" && i + 1 < argc) {
+      m_patternPath = argv[++i];
+      m_seedWorld = seedPatternWorld;
+    } else if (arg == "--at" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%zu,%zu", &m_patternX, &m_patternY) != 2) {
+        std::cerr << "Invalid position " << argv[i] << '\n';
+        return 1;
+      }
+    } else if (arg == "--simulate" && i + 1 < argc) {
+      simulateGenerations = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--size" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%zux%zu", &simulateWidth,
+                      &simulateHeight) != 2) {
+        std::cerr << "Invalid size " << argv[i] << '\n';
+        return 1;
+      }
+    } else if (arg == "--restore" && i + 1 < argc) {
+      restorePath = argv[++i];
+    } else if (arg == "--stream" && i + 1 < argc) {
+      streamPath = argv[++i];
+    } else if (arg == "--checkpoint" && i + 1 < argc) {
+      checkpointPath = argv[++i];
+    } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+      checkpointEvery = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--save-rle" && i + 1 < argc) {
+      rlePath = argv[++i];
+    } else if (arg == "--backend" && i + 1 < argc) {
+      backends = splitList(argv[++i]);
+    } else if (arg == "--tpb" && i + 1 < argc) {
+      // The engines check the values against their device's limit
+      threadOptions.clear();
+      for (const std::string &item : splitList(argv[++i])) {
+        char *end = nullptr;
+        unsigned long threads = std::strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end || threads == 0 ||
+            threads > std::numeric_limits<unsigned>::max()) {
+          std::cerr << "Invalid threads per block " << item << '\n';
+          return 1;
+        }
+        threadOptions.push_back(unsigned(threads));
+      }
+    } else if (arg == "--device" && i + 1 < argc) {
+      engineOptions.device = argv[++i];
+    } else if (arg == "--steps" && i + 1 < argc) {
+      engineOptions.steps = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--cycle" && i + 1 < argc) {
+      cycle.maxPeriod = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--verify-cycle") {
+      cycle.verify = true;
+    } else if (arg == "--stats" && i + 1 < argc) {
+      statsPath = argv[++i];
+    } else if (arg == "--stats-format" && i + 1 < argc &&
+               (std::strcmp(argv[i + 1], "csv") == 0 ||
+                std::strcmp(argv[i + 1], "binary") == 0)) {
+      statsFormat = std::strcmp(argv[++i], "csv") == 0 ? StatsFormat::csv
+                                                        : StatsFormat::binary;
+    } else if (arg == "--check") {
+      check = true;
+    } else if (!parseBenchOption(argc, argv, i, m_bench)) {
+      std::cerr << "Usage: " << argv[0]
+                << " [--threads N] [--rule B3/S23] [--hashlife-memory MiB]\n"
+                   "  [--pattern FILE.rle|FILE.cells] [--at X,Y]\n"
+                   "  [--simulate GENERATIONS] [--size WxH] [--restore FILE]\n"
+                   "  [--checkpoint FILE] [--checkpoint-every N]"
+                   " [--save-rle FILE] [--stream FILE]\n"
+                   "  [--backend NAME,...] [--tpb N,...] [--device gpu|cpu]"
+                   " [--steps K]\n  [--check] [--cycle MAX_PERIOD]"
+                   " [--verify-cycle]\n"
+                   "  [--stats FILE] [--stats-format csv|binary]\n"
+                << benchUsage;
+      return 1;
+    }
+  }
+  bool simulating = streamPath.empty() &&
+                   (simulateGenerations > 0 || !restorePath.empty());
+#ifdef BACKEND
+  // The OpenCL and CUDA binaries run every engine of their backend, and
+  // simulate with the plain one
+  if (backends.empty() && simulating)
+    backends.push_back(BACKEND);
+  if (backends.empty())
+    for (const std::string &key : engineNames())
+      if (key.compare(0, std::strlen(BACKEND), BACKEND) == 0)
+        backends.push_back(key);
+#endif
+  engineOptions.rule = m_rule;
+  if (!backends.empty() && simulating) {
+    if (backends.size() != 1) {
+      std::cerr << "--simulate runs a single --backend\n";
+      return 1;
+    }
+    if (!statsPath.empty()) {
+      std::cerr << "--stats only works with the serial simulation\n";
+      return 1;
+    }
+    engineOptions.threads = threadOptions.empty() ? 0 : threadOptions[0];
+    try {
+      simulateEngine(backends[0], engineOptions, simulateHeight,
+                     simulateWidth, simulateGenerations, restorePath,
+                     checkpointPath, checkpointEvery, rlePath, cycle);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+  if (!backends.empty())
+    return backendExperiment(backends, threadOptions, engineOptions, check);
+
+  if (!checkEngines(m_bench, {"plain", "temporal", "ifs", "active", "threads",
+                              "bitpacked", "block", "simd", "2d", "scaling",
+                              "processes", "hashlife", "active-trace"}))
+    return 1;
+  if (m_bench.sizes.empty())
+    parseSizes("2^15x2^1-10", m_bench.sizes);
+
+  try {
+    if (!streamPath.empty()) {
+      StreamOptions options;
+      options.rule = m_rule;
+      options.world = m_bench.world;
+      uint64_t generation =
+          streamSimulate(restorePath, streamPath, simulateWidth,
+                         simulateHeight, simulateGenerations, options);
+      std::cout << "Generación " << generation << '\n';
+      return 0;
+    }
+    if (simulating) {
+      simulate(simulateHeight, simulateWidth, simulateGenerations, restorePath,
+               checkpointPath, checkpointEvery, rlePath, cycle, statsPath,
+               statsFormat);
+      return 0;
+    }
+    if (!m_patternPath.empty()) {
+      // Fail before the benchmark starts rather than in the middle of it
+      ubyte probe = 0;
+      loadPattern(m_patternPath, &probe, 1, 1, 0, 0);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
     return 1;
   }
-  outfile << "Mode,Width,Height,Length,Iterations,Time[s],Cells/s\n";
+  std::cout << "Kernel SIMD: " << haloKernel << '\n';
 
-  size_t worldWidth = 1ull << 15;
-  for (ushort exp = 1; exp <= 10; ++exp) {
-    size_t worldHeight = 1ull << exp;
-    std::cout << "Ejecutando 2^15" << "x2^" << exp << " ("
-              << worldHeight * worldWidth << ")\n";
-    experiment(16, worldWidth, worldHeight, outfile);
+  BenchReport report(m_bench, "serial_benchmark");
+  report.meta("rule", ruleString(m_rule));
+  report.meta("simd", haloKernel);
+  report.meta("threads", std::to_string(m_threadCount));
+
+  // Scaling, Hashlife and the active trace pick their own world sizes
+  bool sized = m_bench.engines.empty() ||
+               std::any_of(m_bench.engines.begin(), m_bench.engines.end(),
+                           [](const std::string &engine) {
+                             return engine != "scaling" &&
+                                    engine != "processes" &&
+                                    engine != "hashlife" &&
+                                    engine != "active-trace";
+                           });
+  for (size_t i = 0; sized && i < m_bench.sizes.size(); ++i) {
+    const auto &size = m_bench.sizes[i];
+    std::cout << "Ejecutando " << size.first << 'x' << size.second << " ("
+              << size.first * size.second << ")\n";
+    experiment(m_bench.iterations, size.second, size.first, report);
+  }
+  if (benchSelected(m_bench, "scaling"))
+    scalingExperiment(m_bench.iterations, report);
+  try {
+    if (benchSelected(m_bench, "processes"))
+      processScalingExperiment(m_bench.iterations, report);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
   }
+  if (benchSelected(m_bench, "hashlife"))
+    hashlifeExperiment(report);
+  if (benchSelected(m_bench, "active-trace"))
+    activeRegionExperiment(4096);
 
-  outfile.close();
+  try {
+    report.save();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  std::cout << "Resultados en " << report.outputPath() << '\n';
   return 0;
 }
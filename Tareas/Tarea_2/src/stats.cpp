@@ -0,0 +1,147 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+const uint32_t statsVersion = 1;
+
+StatsTally::StatsTally(size_t width, size_t height)
+    : width(width), height(height),
+      tilesPerRow((width + statsTileSize - 1) / statsTileSize),
+      tiles(tilesPerRow * ((height + statsTileSize - 1) / statsTileSize)) {}
+
+void StatsTally::reset() {
+  births = deaths = 0;
+  std::fill(tiles.begin(), tiles.end(), 0);
+}
+
+void StatsTally::countWorld(const ubyte *data) {
+  for (size_t y = 0; y < height; ++y) {
+    uint32_t *row = tileRow(y);
+    for (size_t x = 0; x < width; ++x)
+      row[x / statsTileSize] += data[y * width + x];
+  }
+}
+
+GenerationStats StatsTally::stats(uint64_t generation) const {
+  GenerationStats stats;
+  stats.generation = generation;
+  stats.births = births;
+  stats.deaths = deaths;
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    size_t tileX = i % tilesPerRow * statsTileSize;
+    size_t tileY = i / tilesPerRow * statsTileSize;
+    uint64_t area = std::min(statsTileSize, width - tileX) *
+                    std::min(statsTileSize, height - tileY);
+    stats.population += tiles[i];
+    ++stats.histogram[std::min<uint64_t>(statsBins - 1,
+                                         tiles[i] * statsBins / area)];
+  }
+  return stats;
+}
+
+StatsSink::StatsSink(const std::string &path, StatsFormat format,
+                     size_t width, size_t height, size_t capacity)
+    : path(path), format(format), capacity(capacity),
+      out(path, std::ios::binary) {
+  if (!out)
+    throw std::runtime_error("[Stats] Cannot create " + path + '.');
+
+  if (format == StatsFormat::binary) {
+    StatsHeader header;
+    std::memcpy(header.magic, "LIFESTAT", sizeof(header.magic));
+    header.version = statsVersion;
+    header.bins = statsBins;
+    header.tileSize = statsTileSize;
+    header.width = width;
+    header.height = height;
+    out.write((const char *)&header, sizeof(header));
+  } else {
+    out << "generation,population,births,deaths";
+    for (size_t bin = 0; bin < statsBins; ++bin)
+      out << ",bin" << bin;
+    out << '\n';
+  }
+  pending.reserve(capacity);
+  writer = std::thread(&StatsSink::writerLoop, this);
+}
+
+StatsSink::~StatsSink() {
+  try {
+    close();
+  } catch (const std::exception &) {
+  }
+}
+
+void StatsSink::push(const GenerationStats &stats) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed.wait(lock, [&] { return pending.size() < capacity; });
+  pending.push_back(stats);
+  // The writer only sleeps on an empty queue
+  if (pending.size() == 1)
+    changed.notify_all();
+}
+
+void StatsSink::close() {
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+    out.close();
+    failed = failed || !out;
+  }
+  if (failed)
+    throw std::runtime_error("[Stats] Failed writing " + path + '.');
+}
+
+void StatsSink::writerLoop() {
+  std::vector<GenerationStats> batch;
+  batch.reserve(capacity);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      changed.wait(lock, [&] { return stopping || !pending.empty(); });
+      if (pending.empty())
+        return;
+      batch.swap(pending);
+    }
+    changed.notify_all();
+    write(batch);
+    batch.clear();
+  }
+}
+
+void StatsSink::write(const std::vector<GenerationStats> &batch) {
+  if (format == StatsFormat::binary) {
+    std::vector<uint64_t> words;
+    words.reserve(batch.size() * (4 + statsBins));
+    for (const GenerationStats &stats : batch) {
+      words.insert(words.end(), {stats.generation, stats.population,
+                                 stats.births, stats.deaths});
+      words.insert(words.end(), stats.histogram.begin(),
+                   stats.histogram.end());
+    }
+    out.write((const char *)words.data(), words.size() * sizeof(uint64_t));
+  } else {
+    std::string text;
+    for (const GenerationStats &stats : batch) {
+      text += std::to_string(stats.generation) + ',' +
+              std::to_string(stats.population) + ',' +
+              std::to_string(stats.births) + ',' +
+              std::to_string(stats.deaths);
+      for (uint64_t tiles : stats.histogram)
+        text += ',' + std::to_string(tiles);
+      text += '\n';
+    }
+    out << text;
+  }
+  if (!out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    failed = true;
+  }
+}
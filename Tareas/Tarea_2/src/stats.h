@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef unsigned char ubyte;
+
+// Per-generation statistics. The update loops count births, deaths and the
+// population of every tile while they write the next generation, so turning
+// them on costs no pass over the world; turning them off selects the plain
+// loops.
+const size_t statsTileSize = 64; // Cells per side of a histogram tile
+const size_t statsBins = 8;      // Density bins of width 1 / statsBins
+
+struct GenerationStats {
+  uint64_t generation = 0;
+  uint64_t population = 0;
+  uint64_t births = 0;
+  uint64_t deaths = 0;
+  std::array<uint64_t, statsBins> histogram{}; // Tiles per density bin
+};
+
+// Counters one generation fills in. Tiles on the right and bottom edges may
+// be smaller than statsTileSize; their density uses their own area.
+class StatsTally {
+public:
+  StatsTally(size_t width, size_t height);
+
+  void reset(); // Before every generation
+
+  // Population counters of the tiles covering row y, one per tile column
+  uint32_t *tileRow(size_t y) {
+    return tiles.data() + y / statsTileSize * tilesPerRow;
+  }
+
+  // Adds every alive cell of a flat world, for the first generation of a run
+  void countWorld(const ubyte *data);
+
+  GenerationStats stats(uint64_t generation) const;
+
+  uint64_t births = 0, deaths = 0;
+
+private:
+  size_t width, height;
+  size_t tilesPerRow;
+  std::vector<uint32_t> tiles;
+};
+
+enum class StatsFormat { csv, binary };
+
+// Binary stats files start with this header, followed by one record per
+// generation of 4 + statsBins uint64: generation, population, births, deaths
+// and the histogram. Header and records are written in the machine's byte
+// order, like snapshots.
+struct StatsHeader {
+  char magic[8]; // "LIFESTAT"
+  uint32_t version;
+  uint32_t bins;
+  uint64_t tileSize;
+  uint64_t width;
+  uint64_t height;
+};
+
+// Writes records from a background thread. push() only queues a copy, the
+// writer formats and writes whole batches, so the simulation waits only
+// when `capacity` records are already queued.
+class StatsSink {
+public:
+  StatsSink(const std::string &path, StatsFormat format, size_t width,
+            size_t height, size_t capacity = 4096);
+  ~StatsSink();
+
+  StatsSink(const StatsSink &) = delete;
+  StatsSink &operator=(const StatsSink &) = delete;
+
+  void push(const GenerationStats &stats);
+
+  // Drains the queue and reports write errors; the destructor only drains
+  void close();
+
+private:
+  void writerLoop();
+  void write(const std::vector<GenerationStats> &batch);
+
+  std::string path;
+  StatsFormat format;
+  size_t capacity;
+  std::ofstream out;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<GenerationStats> pending;
+  bool stopping = false;
+  bool failed = false;
+  std::thread writer;
+};
@@ -0,0 +1,237 @@
+#include "stream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bitboard.h"
+#include "pattern.h"
+
+// Snapshot mapped shared, read-only for inputs and read-write for outputs,
+// which are created at full size so every band is written in place.
+class StreamFile {
+public:
+  explicit StreamFile(const std::string &path) : path(path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("[Stream] Cannot open " + path + '.');
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      throw std::runtime_error("[Stream] Cannot read " + path + '.');
+    }
+    map(info.st_size, PROT_READ);
+    if (!isSnapshotHeader(header(), mappingSize)) {
+      unmap();
+      throw std::runtime_error("[Stream] " + path +
+                               " is not a supported snapshot.");
+    }
+  }
+
+  StreamFile(const std::string &path, const SnapshotHeader &layout)
+      : path(path), writable(true) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("[Stream] Cannot create " + path + '.');
+    size_t size = layout.headerSize +
+                  layout.height * layout.wordsPerRow * sizeof(uint64_t);
+    if (ftruncate(fd, size) != 0) {
+      close(fd);
+      throw std::runtime_error("[Stream] Cannot grow " + path + " to " +
+                               std::to_string(size) + " bytes.");
+    }
+    map(size, PROT_READ | PROT_WRITE);
+    std::memcpy(mapping, &layout, sizeof(layout));
+  }
+
+  StreamFile(const StreamFile &) = delete;
+  StreamFile &operator=(const StreamFile &) = delete;
+  ~StreamFile() { unmap(); }
+
+  const SnapshotHeader &header() const {
+    return *(const SnapshotHeader *)mapping;
+  }
+
+  uint64_t *row(size_t y) const {
+    return (uint64_t *)((char *)mapping + offset(y));
+  }
+
+  // Rows [begin, end) are needed next, readahead starts now
+  void prefetch(size_t begin, size_t end) {
+    size_t first = offset(begin) / pageSize * pageSize;
+    madvise((char *)mapping + first, offset(end) - first, MADV_WILLNEED);
+  }
+
+  // Starts writing rows [begin, end) back without waiting for the disk
+  void flush(size_t begin, size_t end) {
+    if (writable)
+      sync_file_range(fd, offset(begin), offset(end) - offset(begin),
+                      SYNC_FILE_RANGE_WRITE);
+  }
+
+  // Rows [begin, end) are done. Waits for their writeback and drops the
+  // whole pages among them from the mapping and the page cache. Callers
+  // flush a band and release it only once the next band has been flushed
+  // too, so the wait finds the disk already done or busy with later rows.
+  void release(size_t begin, size_t end) {
+    size_t first = (offset(begin) + pageSize - 1) / pageSize * pageSize;
+    size_t last = offset(end) / pageSize * pageSize;
+    if (writable)
+      sync_file_range(fd, offset(begin), offset(end) - offset(begin),
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                          SYNC_FILE_RANGE_WAIT_AFTER);
+    if (first >= last)
+      return;
+    madvise((char *)mapping + first, last - first, MADV_DONTNEED);
+    posix_fadvise(fd, first, last - first, POSIX_FADV_DONTNEED);
+  }
+
+  // Makes the whole file durable before the next generation replaces the
+  // one it was read from
+  void finish() {
+    if (writable && fsync(fd) != 0)
+      throw std::runtime_error("[Stream] Failed writing " + path + '.');
+  }
+
+private:
+  size_t offset(size_t y) const {
+    return header().headerSize + y * header().wordsPerRow * sizeof(uint64_t);
+  }
+
+  void map(size_t size, int protection) {
+    mappingSize = size;
+    mapping = mmap(nullptr, mappingSize, protection, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      close(fd);
+      throw std::runtime_error("[Stream] Cannot map " + path + '.');
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+  }
+
+  void unmap() {
+    if (mapping)
+      munmap(mapping, mappingSize);
+    close(fd);
+    mapping = nullptr;
+  }
+
+  std::string path;
+  bool writable = false;
+  int fd = -1;
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+  const size_t pageSize = sysconf(_SC_PAGESIZE);
+};
+
+static size_t bandRows(const SnapshotHeader &header, size_t bandBytes) {
+  return std::max<size_t>(1, bandBytes / (header.wordsPerRow *
+                                          sizeof(uint64_t)));
+}
+
+// Same world fillRandomWorld gives the in-memory engines
+static void seedStream(StreamFile &out, size_t bandBytes,
+                       const RandomOptions &world) {
+  const SnapshotHeader &header = out.header();
+  size_t rows = bandRows(header, bandBytes);
+  size_t bands = (header.height + rows - 1) / rows;
+  auto begin = [&](size_t band) { return band * rows; };
+  auto end = [&](size_t band) {
+    return std::min<size_t>(header.height, (band + 1) * rows);
+  };
+
+  for (size_t band = 0; band < bands; ++band) {
+    for (size_t y = begin(band); y < end(band); ++y)
+      fillRandomBits(out.row(y), y * header.width, header.width, world);
+    out.flush(begin(band), end(band));
+
+    // The previous band was written back while this one was filled
+    if (band > 0)
+      out.release(begin(band - 1), end(band - 1));
+  }
+  out.release(begin(bands - 1), end(bands - 1));
+  out.finish();
+}
+
+static void streamGeneration(StreamFile &in, StreamFile &out,
+                             size_t bandBytes, const Rule &rule) {
+  size_t height = in.header().height;
+  size_t words = in.header().wordsPerRow;
+  size_t rows = bandRows(in.header(), bandBytes);
+  size_t bands = (height + rows - 1) / rows;
+  auto begin = [&](size_t band) { return band * rows; };
+  auto end = [&](size_t band) { return std::min(height, (band + 1) * rows); };
+
+  // The first band also reads the last row, the last band the first row
+  in.prefetch(begin(0), end(0));
+  in.prefetch(height - 1, height);
+  for (size_t band = 0; band < bands; ++band) {
+    if (band + 1 < bands)
+      in.prefetch(begin(band + 1), end(band + 1));
+    else
+      in.prefetch(0, 1);
+
+    for (size_t y = begin(band); y < end(band); ++y)
+      computeBitboardRow(in.row((y + height - 1) % height), in.row(y),
+                         in.row((y + 1) % height), out.row(y), words, rule);
+    out.flush(begin(band), end(band));
+
+    // Nothing reads the band before this one any more
+    if (band > 0) {
+      in.release(begin(band - 1), end(band - 1));
+      out.release(begin(band - 1), end(band - 1));
+    }
+  }
+  in.release(begin(bands - 1), end(bands - 1));
+  out.release(begin(bands - 1), end(bands - 1));
+  out.finish();
+}
+
+uint64_t streamSimulate(const std::string &input, const std::string &output,
+                        size_t width, size_t height, size_t generations,
+                        const StreamOptions &options) {
+  if (generations == 0)
+    throw std::logic_error("[Stream] Nothing to stream without --simulate.");
+
+  // Generation g goes to `output` when generations - g is even, so the last
+  // one ends there and the two files take turns
+  std::string scratch = output + ".part";
+  auto target = [&](size_t g) {
+    return (generations - g) % 2 == 0 ? output : scratch;
+  };
+  if (input == output || input == scratch)
+    throw std::logic_error("[Stream] The output would overwrite " + input +
+                           '.');
+
+  std::string source = input;
+  if (source.empty()) {
+    if (width % 64 != 0 || height == 0)
+      throw std::logic_error("[Stream] Streaming needs a width multiple of "
+                             "64.");
+    source = target(0);
+    StreamFile seeded(source, snapshotHeader(width, height, 0));
+    seedStream(seeded, options.bandBytes, options.world);
+  }
+
+  uint64_t generation = 0;
+  for (size_t g = 1; g <= generations; ++g) {
+    StreamFile in(source);
+    const SnapshotHeader &header = in.header();
+    if (header.width % 64 != 0 || header.height == 0)
+      throw std::logic_error("[Stream] Streaming needs a width multiple of "
+                             "64.");
+    generation = header.generation + 1;
+    StreamFile out(target(g),
+                   snapshotHeader(header.width, header.height, generation));
+    streamGeneration(in, out, options.bandBytes, options.rule);
+    source = target(g);
+  }
+  std::remove(scratch.c_str());
+  return generation;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "random.h"
+#include "rule.h"
+
+// Out-of-core simulation for worlds larger than memory. Every generation
+// reads one bit-packed snapshot file (see pattern.h) and writes the next one,
+// both mapped into the address space. Rows go through in bands with a window
+// of three: the next band is prefetched, the current one computed and the
+// previous one written back and dropped from the page cache, so resident
+// memory stays at a few bands whatever the world size.
+struct StreamOptions {
+  Rule rule = conwayRule;
+  size_t bandBytes = size_t(64) << 20; // Packed rows per band, rounded down
+  RandomOptions world;                 // Random worlds only
+};
+
+// Advances the snapshot at `input`, or a random width x height world drawn
+// from options.world when it is empty, `generations` times and leaves the
+// result in `output`. Returns the generation reached. `output` + ".part"
+// holds every other generation and is removed at the end. Widths must be a
+// multiple of 64.
+uint64_t streamSimulate(const std::string &input, const std::string &output,
+                        size_t width, size_t height, size_t generations,
+                        const StreamOptions &options);